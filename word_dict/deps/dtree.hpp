@@ -25,23 +25,196 @@
 #ifndef DTREE_H
 #define DTREE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// Source of memory for dtree nodes (see dtree_allocator below and the
+/// implementations available in dtree_resources.hpp).
+class dtree_memory_resource
+{
+public:
+    virtual ~dtree_memory_resource() {}
+
+    virtual void* allocate(size_t bytes, size_t alignment) = 0;
+    virtual void deallocate(void *ptr, size_t bytes, size_t alignment) = 0;
+
+    /// Same as allocate() and deallocate() but without a virtual call in the
+    /// common cases, for use by dtree_allocator: memory is bumped from the
+    /// current block of the resource, and chunks of the size of tree nodes
+    /// are recycled through a free list, when the resource sets these up (see
+    /// protected members below). The virtual functions are called otherwise.
+    /// Only chunks are bumped inline, so that resources rounding the other
+    /// allocations up to size classes do so in allocate(), unless the resource
+    /// bumps allocations of any size as they are (m_bumps_any_size).
+    void* allocate_inline(size_t bytes, size_t alignment)
+    {
+        if(bytes == m_chunk_bytes && m_free_chunks) {
+            void *chunk = m_free_chunks;
+            m_free_chunks = *static_cast<void**>(chunk);
+            m_bytes_allocated += bytes;
+            return chunk;
+        }
+        if((bytes == m_chunk_bytes && m_chunk_bytes != 0) || m_bumps_any_size) {
+            const size_t block_alignment = alignment < m_block_alignment ? m_block_alignment : alignment;
+            const uintptr_t address = (m_block_next + block_alignment - 1) & ~static_cast<uintptr_t>(block_alignment - 1);
+            if(address + bytes <= m_block_end) {
+                m_block_next = address + bytes;
+                m_bytes_allocated += bytes;
+                return reinterpret_cast<void*>(address);
+            }
+        }
+        return allocate(bytes, alignment);
+    }
+    void deallocate_inline(void *ptr, size_t bytes, size_t alignment)
+    {
+        if(bytes == m_chunk_bytes) {
+            *static_cast<void**>(ptr) = m_free_chunks;
+            m_free_chunks = ptr;
+            m_bytes_allocated -= bytes;
+            return;
+        }
+        deallocate(ptr, bytes, alignment);
+    }
+
+    /// Tells whether all memory allocated from this resource is released when
+    /// the resource is destroyed, in which case a tree whose nodes are all
+    /// allocated from this resource doesn't need to be destroyed node by node.
+    virtual bool releases_all_on_destruction() const { return false; }
+
+    /// Returns the resource of the given index (from 0) for use by another
+    /// thread (resources are not thread-safe), of the same kind as this
+    /// resource. The resource is created on first request, then returned by
+    /// the next requests (so the memory it reserved is reused), and destroyed
+    /// along with this resource. A null pointer means that this resource can
+    /// be used by any thread.
+    virtual dtree_memory_resource* thread_resource(size_t index) = 0;
+
+    /// Returns the number of bytes currently allocated from this resource, and
+    /// the number of bytes obtained from the system to serve them, both
+    /// including the resources returned by thread_resource(). Resources
+    /// which don't keep track of them return 0.
+    virtual size_t bytes_allocated() const { return 0; }
+    virtual size_t bytes_reserved() const { return 0; }
+
+protected:
+    uintptr_t m_block_next {0};      // next free byte of the current block
+    uintptr_t m_block_end {0};       // end of the current block (0: no block)
+    size_t m_block_alignment {1};    // minimal alignment of the memory bumped from blocks
+    size_t m_chunk_bytes {0};        // size of the chunks in m_free_chunks (0: no chunk is recycled)
+    bool m_bumps_any_size {false};   // whether allocations of any size are bumped inline, without rounding
+    void *m_free_chunks {nullptr};   // deallocated chunks, each one storing a pointer to the next
+    size_t m_bytes_allocated {0};    // maintained by the inline functions as well
+};
+
+/// Allocator for dtree nodes, allocating from the given memory resource or from
+/// the global operator new if the resource is null (default).
+template<typename U>
+class dtree_allocator
+{
+public:
+    typedef U value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+public:
+    dtree_allocator(dtree_memory_resource *resource = nullptr) : m_resource(resource) {}
+    template<typename V>
+    dtree_allocator(const dtree_allocator<V> &other) : m_resource(other.resource()) {}
+
+    U* allocate(size_t n)
+    {
+        if(!m_resource) {
+            return static_cast<U*>(::operator new(n * sizeof(U)));
+        }
+        return static_cast<U*>(m_resource->allocate_inline(n * sizeof(U), alignof(U)));
+    }
+    void deallocate(U *ptr, size_t n)
+    {
+        if(!m_resource) {
+            ::operator delete(ptr);
+            return;
+        }
+        m_resource->deallocate_inline(ptr, n * sizeof(U), alignof(U));
+    }
+
+    dtree_memory_resource* resource() const { return m_resource; }
+
+private:
+    dtree_memory_resource *m_resource;
+};
+
+template<typename U, typename V>
+bool operator==(const dtree_allocator<U> &a, const dtree_allocator<V> &b) { return a.resource() == b.resource(); }
+template<typename U, typename V>
+bool operator!=(const dtree_allocator<U> &a, const dtree_allocator<V> &b) { return !(a == b); }
+
+/// Tells whether the nodes allocated with the given allocator need not be
+/// destroyed one by one (see dtree_memory_resource).
+template<typename Allocator>
+bool dtree_releases_all_on_destruction(const Allocator &) { return false; }
+template<typename U>
+bool dtree_releases_all_on_destruction(const dtree_allocator<U> &allocator)
+{
+    return allocator.resource() && allocator.resource()->releases_all_on_destruction();
+}
 
 /// A node with possible connections to child nodes. Designed for use with the
-/// dtree tree implementation available below.
-template<typename T>
+/// dtree tree implementation available below. Children are allocated using
+/// the allocator given to the node, which is passed on to the children.
+template<typename T, typename Allocator = dtree_allocator<T>>
 class dtree_node {
 private:
-    typedef std::map<T, dtree_node> map_t; // map type for this nodes's children
+    typedef std::pair<const T, dtree_node> value_t;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<value_t> map_allocator_t;
+    typedef std::map<T, dtree_node, std::less<T>, map_allocator_t> map_t; // map type for this nodes's children
 
 public:
-    explicit dtree_node() {}
+    typedef Allocator allocator_type;                      // allocator for this node's children
+    typedef typename map_t::iterator iterator;             // iterator over this node's children
+    typedef typename map_t::const_iterator const_iterator; // const iterator over this node's children
+
+public:
+    explicit dtree_node(const Allocator &allocator = Allocator()) : m_children(map_allocator_t(allocator)) {}
+
+    /// Copies the given node and its offspring, allocating them with the given
+    /// allocator (with the allocator of the given node by default).
+    dtree_node(const dtree_node &other, const Allocator &allocator)
+        : m_children(map_allocator_t(allocator))
+    {
+        for(const auto &child : other.m_children) {
+            m_children.emplace_hint(m_children.end(),
+                                    std::piecewise_construct,
+                                    std::forward_as_tuple(child.first),
+                                    std::forward_as_tuple(child.second, allocator));
+        }
+    }
+    dtree_node(const dtree_node &other) : dtree_node(other, other.get_allocator()) {}
+    dtree_node(dtree_node &&) = default;
+
+    /// Replaces this node's offspring with a copy of the given node's, which
+    /// is allocated with this node's allocator.
+    dtree_node& operator=(const dtree_node &other)
+    {
+        if(this != &other) {
+            dtree_node copy(other, get_allocator());
+            m_children.swap(copy.m_children);
+        }
+        return *this;
+    }
+    dtree_node& operator=(dtree_node &&) = default;
+
+    Allocator get_allocator() const { return Allocator(m_children.get_allocator()); }
 
     /// Returns a possibly null pointer to a chid of this node.
     const dtree_node* child_ptr(const T &input) const
     {
-        try { return &m_children.at(input); } catch(std::out_of_range &) {}
-        return nullptr;
+        const auto it = m_children.find(input);
+        return it != m_children.end() ? &it->second : nullptr;
     }
     dtree_node* child_ptr(const T &input)
     {
@@ -51,7 +224,31 @@ public:
 
     /// Inserts and returns this node's child for the given input. The child
     /// node is inserted only once.
-    dtree_node& set_child(const T &input) { return m_children[input]; }
+    dtree_node& set_child(const T &input)
+    {
+        auto it = m_children.lower_bound(input);
+        if(it == m_children.end() || input < it->first) {
+            it = m_children.emplace_hint(it,
+                                         std::piecewise_construct,
+                                         std::forward_as_tuple(input),
+                                         std::forward_as_tuple(get_allocator()));
+        }
+        return it->second;
+    }
+
+    /// Attaches the given node (and its offspring) as this node's child for
+    /// the given input, without copying, and returns success/failure. Nothing
+    /// is done (and the given node is left untouched) if the child already
+    /// exists.
+    bool attach_child(const T &input, dtree_node &&child)
+    {
+        const auto it = m_children.lower_bound(input);
+        if(it != m_children.end() && !(input < it->first)) {
+            return false;
+        }
+        m_children.emplace_hint(it, input, std::move(child));
+        return true;
+    }
 
     /// Removes the child node for the given input and returns success/failure.
     bool unset_child(const T &input) { return m_children.erase(input) == 1; }
@@ -61,12 +258,17 @@ public:
     bool has_children() const { return !m_children.empty(); }
 
     /// std::map::begin() functions to iterate over this node's children.
-    typename map_t::iterator begin() { return m_children.begin(); }
-    typename map_t::const_iterator begin() const { return m_children.begin(); }
+    iterator begin() { return m_children.begin(); }
+    const_iterator begin() const { return m_children.begin(); }
 
     /// std::map::end() functions to iterate over this node's children.
-    typename map_t::iterator end() { return m_children.end(); }
-    typename map_t::const_iterator end() const { return m_children.end(); }
+    iterator end() { return m_children.end(); }
+    const_iterator end() const { return m_children.end(); }
+
+    /// std::map::lower_bound() functions to find this node's first child whose
+    /// input is not less than the given input.
+    iterator lower_bound(const T &input) { return m_children.lower_bound(input); }
+    const_iterator lower_bound(const T &input) const { return m_children.lower_bound(input); }
 
 private:
     map_t m_children;
@@ -84,20 +286,37 @@ private:
 ///     - not versatile (limited to top->bottom tree traversal only).
 ///     - tree traversal does not preserve the order in which nodes are inserted
 ///       (order is defined by std::map).
-template<typename T>
+/// Nodes are allocated with the given allocator. When it allocates from a
+/// resource releasing all its memory on destruction (e.g. a monotonic arena),
+/// destroying the tree is O(1) because nodes are not destroyed one by one: all
+/// nodes must then be allocated from that resource (or from the resources it
+/// creates for other threads) and the resource must outlive the tree. Copies
+/// of a tree allocate their nodes with the allocator of the tree unless
+/// another one is given.
+template<typename T, typename Allocator = dtree_allocator<T>>
 class dtree
 {
 public:
-    typedef dtree_node<T> node_t; // node type
+    typedef dtree_node<T, Allocator> node_t; // node type
 
 public:
-    explicit dtree() {}
+    explicit dtree(const Allocator &allocator = Allocator()) { new (&m_root) node_t(allocator); }
+    ~dtree()
+    {
+        if(!dtree_releases_all_on_destruction(m_root.get_allocator())) {
+            m_root.~node_t();
+        }
+    }
+
+    dtree(const dtree &other, const Allocator &allocator) { new (&m_root) node_t(other.m_root, allocator); }
+    dtree(const dtree &other) : dtree(other, other.m_root.get_allocator()) {}
+    dtree& operator=(const dtree &other) { m_root = other.m_root; return *this; }
 
     node_t& root() { return m_root; }
     const node_t& root() const { return m_root; }
 
 private:
-    node_t m_root;
+    union { node_t m_root; }; // destroyed on demand only (see above)
 };
 
 #endif // DTREE_H
@@ -0,0 +1,223 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef DTREE_RESOURCES_H
+#define DTREE_RESOURCES_H
+
+#include "dtree.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// Base of the memory resources below, handing out memory from large blocks
+/// which are all released at once when the resource is destroyed. Memory is
+/// bumped from the current block by dtree_memory_resource::allocate_inline()
+/// (i.e. without a virtual call) until the block is full.
+class dtree_block_resource : public dtree_memory_resource
+{
+public:
+    ~dtree_block_resource()
+    {
+        for(void *block : m_blocks) {
+            ::operator delete(block);
+        }
+    }
+
+    dtree_block_resource(const dtree_block_resource &) = delete;
+    dtree_block_resource& operator=(const dtree_block_resource &) = delete;
+
+    bool releases_all_on_destruction() const override { return true; }
+
+    dtree_memory_resource* thread_resource(size_t index) override
+    {
+        std::lock_guard<std::mutex> lock(m_thread_resources_mutex);
+        while(m_thread_resources.size() <= index) {
+            m_thread_resources.emplace_back(new_thread_resource());
+        }
+        return m_thread_resources[index].get();
+    }
+
+    size_t bytes_allocated() const override
+    {
+        std::lock_guard<std::mutex> lock(m_thread_resources_mutex);
+        size_t bytes = m_bytes_allocated;
+        for(const auto &resource : m_thread_resources) {
+            bytes += resource->bytes_allocated();
+        }
+        return bytes;
+    }
+    size_t bytes_reserved() const override
+    {
+        std::lock_guard<std::mutex> lock(m_thread_resources_mutex);
+        size_t bytes = m_bytes_reserved;
+        for(const auto &resource : m_thread_resources) {
+            bytes += resource->bytes_reserved();
+        }
+        return bytes;
+    }
+
+protected:
+    dtree_block_resource(size_t block_size, size_t block_alignment) : m_block_size(block_size)
+    {
+        m_block_alignment = block_alignment;
+    }
+
+    /// Bumps memory from the current block, starting a new block if needed.
+    /// Allocated bytes are not counted.
+    void* allocate_from_blocks(size_t bytes, size_t alignment)
+    {
+        alignment = std::max(alignment, m_block_alignment);
+        uintptr_t address = (m_block_next + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        if(address + bytes > m_block_end) {
+            const size_t block_size = std::max(m_block_size, bytes + alignment);
+            void *block = ::operator new(block_size);
+            m_blocks.push_back(block);
+            m_bytes_reserved += block_size;
+            m_block_next = reinterpret_cast<uintptr_t>(block);
+            m_block_end = m_block_next + block_size;
+            address = (m_block_next + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        }
+        m_block_next = address + bytes;
+        return reinterpret_cast<void*>(address);
+    }
+
+    /// Returns a new resource of the same kind (see thread_resource()).
+    virtual dtree_block_resource* new_thread_resource() const = 0;
+
+protected:
+    const size_t m_block_size;
+
+private:
+    std::vector<void*> m_blocks;
+    size_t m_bytes_reserved {0};
+
+    mutable std::mutex m_thread_resources_mutex;
+    std::vector<std::unique_ptr<dtree_block_resource>> m_thread_resources;
+};
+
+/// Memory resource handing out memory from large blocks, never reusing
+/// deallocated memory (deallocation does nothing). Suitable for trees which
+/// are built once and rarely modified afterwards.
+class dtree_monotonic_arena : public dtree_block_resource
+{
+public:
+    explicit dtree_monotonic_arena(size_t block_size = 1 << 16) : dtree_block_resource(block_size, 1)
+    {
+        m_bumps_any_size = true;
+    }
+
+    /// Deallocated memory is never reused so it is still counted as allocated.
+    void* allocate(size_t bytes, size_t alignment) override
+    {
+        m_bytes_allocated += bytes;
+        return allocate_from_blocks(bytes, alignment);
+    }
+    void deallocate(void *, size_t, size_t) override {}
+
+protected:
+    dtree_block_resource* new_thread_resource() const override
+    {
+        return new dtree_monotonic_arena(m_block_size);
+    }
+};
+
+/// Memory resource handing out memory from large blocks, deallocated memory
+/// being reused for allocations of the same size class. Chunks of chunk_bytes
+/// bytes (e.g. dtree_utils::node_allocation_bytes(), the size of the nodes of
+/// a tree) have their own free list which is used without a virtual call
+/// (see dtree_memory_resource::allocate_inline()). Suitable for trees which
+/// are modified often. Alignments greater than alignof(std::max_align_t) are
+/// not supported.
+class dtree_pool_resource : public dtree_block_resource
+{
+public:
+    explicit dtree_pool_resource(size_t block_size = 1 << 16, size_t chunk_bytes = 0)
+        : dtree_block_resource(block_size, alignof(std::max_align_t))
+    {
+        m_chunk_bytes = chunk_bytes >= sizeof(free_chunk) ? chunk_bytes : 0;
+    }
+
+    void* allocate(size_t bytes, size_t alignment) override
+    {
+        m_bytes_allocated += bytes;
+        if(bytes == m_chunk_bytes) {
+            if(m_free_chunks) {
+                void *chunk = m_free_chunks;
+                m_free_chunks = static_cast<free_chunk*>(chunk)->next;
+                return chunk;
+            }
+            return allocate_from_blocks(bytes, alignment);
+        }
+        const size_t size_class = size_class_of(bytes, alignment);
+        if(size_class < m_free_lists.size() && m_free_lists[size_class]) {
+            free_chunk *chunk = m_free_lists[size_class];
+            m_free_lists[size_class] = chunk->next;
+            return chunk;
+        }
+        return allocate_from_blocks(size_class_bytes(size_class), alignment);
+    }
+    void deallocate(void *ptr, size_t bytes, size_t alignment) override
+    {
+        m_bytes_allocated -= bytes;
+        free_chunk *chunk = static_cast<free_chunk*>(ptr);
+        if(bytes == m_chunk_bytes) {
+            chunk->next = static_cast<free_chunk*>(m_free_chunks);
+            m_free_chunks = chunk;
+            return;
+        }
+        const size_t size_class = size_class_of(bytes, alignment);
+        if(size_class >= m_free_lists.size()) {
+            m_free_lists.resize(size_class + 1, nullptr);
+        }
+        chunk->next = m_free_lists[size_class];
+        m_free_lists[size_class] = chunk;
+    }
+
+protected:
+    dtree_block_resource* new_thread_resource() const override
+    {
+        return new dtree_pool_resource(m_block_size, m_chunk_bytes);
+    }
+
+private:
+    struct free_chunk { free_chunk *next; };
+
+    static const size_t size_class_granularity {16};
+
+    static size_t size_class_of(size_t bytes, size_t alignment)
+    {
+        bytes = std::max({bytes, alignment, sizeof(free_chunk)});
+        return (bytes + size_class_granularity - 1) / size_class_granularity;
+    }
+    static size_t size_class_bytes(size_t size_class) { return size_class * size_class_granularity; }
+
+private:
+    std::vector<free_chunk*> m_free_lists; // one list of free chunks per size class (other than chunk_bytes)
+};
+
+#endif // DTREE_RESOURCES_H
@@ -27,26 +27,87 @@
 
 #include "dtree.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 /// Utility class for the templated dtree class.
 class dtree_utils
 {
+public:
+    /// Shape and size of a tree (see compute_tree_stats()). Counts include
+    /// the root node.
+    typedef struct {
+        size_t node_count {0};
+        size_t leaf_count {0};
+        size_t height {0};                    // depth of the deepest node (root is at depth 0)
+        std::vector<size_t> fanout_histogram; // number of nodes per number of children
+        std::vector<size_t> depth_histogram;  // number of nodes per depth
+        size_t payload_bytes {0};             // bytes of the values read to reach nodes
+        size_t container_bytes {0};           // bytes of the nodes and of the bookkeeping of their parent's container
+    } tree_stats;
+
 public:
     dtree_utils() = delete;
 
+    /// Returns the estimated number of bytes allocated for each node other
+    /// than the root: the node is stored along with the value read to reach
+    /// it in a node of its parent's container, whose bookkeeping is assumed
+    /// to take four pointers as in the usual red-black tree implementations.
+    template<typename T, typename Allocator>
+    static size_t node_allocation_bytes()
+    {
+        return sizeof(std::pair<const T, dtree_node<T, Allocator>>) + 4 * sizeof(void*);
+    }
+
+    /// Computes the shape and size of tree without recursion. The tree is
+    /// traversed depth-first using a stack whose size is bounded by the total
+    /// number of children of the nodes along a path from root.
+    template<typename T, typename Allocator>
+    static tree_stats compute_tree_stats(const dtree<T, Allocator>& tree)
+    {
+        return compute_tree_stats(tree.root());
+    }
+    template<typename T, typename Allocator>
+    static tree_stats compute_tree_stats(const dtree_node<T, Allocator> &node)
+    {
+        tree_stats stats;
+        stats.container_bytes = sizeof(node); // root is not stored in a container
+        std::vector<std::pair<const dtree_node<T, Allocator>*, size_t>> unvisited_nodes {{&node, 0}};
+        while(!unvisited_nodes.empty()) {
+            const dtree_node<T, Allocator> *curr_node = unvisited_nodes.back().first;
+            const size_t depth = unvisited_nodes.back().second;
+            unvisited_nodes.pop_back();
+
+            const size_t nb_children = curr_node->number_of_children();
+            stats.node_count++;
+            stats.leaf_count += nb_children == 0 ? 1 : 0;
+            stats.height = std::max(stats.height, depth);
+            increment_histogram(stats.fanout_histogram, nb_children);
+            increment_histogram(stats.depth_histogram, depth);
+            stats.payload_bytes += nb_children * sizeof(T);
+            stats.container_bytes += nb_children * (node_allocation_bytes<T, Allocator>() - sizeof(T));
+
+            for(auto it = curr_node->begin(); it != curr_node->end(); it++) {
+                unvisited_nodes.emplace_back(&it->second, depth + 1);
+            }
+        }
+        return stats;
+    }
+
     /// Prints tree starting at root node.
-    template<typename T>
-    static void print_tree_bracketed(const dtree<T>& tree,
+    template<typename T, typename Allocator>
+    static void print_tree_bracketed(const dtree<T, Allocator>& tree,
                                      std::ostream& stream = std::cout)
     {
-        print_tree_bracketed<T>(tree.root(), stream);
+        print_tree_bracketed(tree.root(), stream);
     }
 
     /// Prints tree starting at the given node. Tree is printed as a node
     /// followed by the set of possible subtrees (one per child node).
-    template<typename T>
-    static void print_tree_bracketed(const typename dtree<T>::node_t &node,
+    template<typename T, typename Allocator>
+    static void print_tree_bracketed(const dtree_node<T, Allocator> &node,
                                      std::ostream& stream = std::cout)
     {
         const size_t node_index_max = node.number_of_children() - 1;
@@ -60,8 +121,16 @@ public:
     }
 
 private:
-    template<typename T>
-    static void print_sub_tree_bracketed(const typename dtree<T>::node_t &node,
+    static void increment_histogram(std::vector<size_t> &histogram, size_t value)
+    {
+        if(value >= histogram.size()) {
+            histogram.resize(value + 1, 0);
+        }
+        histogram[value]++;
+    }
+
+    template<typename T, typename Allocator>
+    static void print_sub_tree_bracketed(const dtree_node<T, Allocator> &node,
                                          const T &input_from_parent,
                                          std::ostream& stream = std::cout)
     {
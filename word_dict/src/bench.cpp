@@ -0,0 +1,288 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "bench_utils.hpp"
+
+#include <cstdlib>
+#include <limits>
+
+int main(int argc, char *argv[])
+{
+    // usage: word_dict_bench [number_of_words [number_of_queries]]
+    const size_t nb_words = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const size_t nb_queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+    const unsigned int budget_max = 4;
+
+    word_dict dict;
+    const std::vector<std::string> &words = generate_words(nb_words, 1, 12, "abcdefghij", 1);
+    const std::vector<std::string> &queries = generate_words(nb_queries, 1, 12, "abcdefghij", 2);
+
+    std::cout << "--- Add " << nb_words << " random words ---" << std::endl;
+    std::cout << "add_word():  " << time_ms([&]() {
+        for(const std::string &word : words) {
+            dict.add_word(word);
+        }
+    }) << " ms" << std::endl;
+    for(unsigned int prefix_length = 1; prefix_length <= 2; prefix_length++) {
+        word_dict parallel_dict;
+        std::cout << "add_words(): " << time_ms([&]() {
+            parallel_dict.add_words(words, 0, prefix_length);
+        }) << " ms (prefix length: " << prefix_length << ")" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "--- Build and destroy dictionaries of " << nb_words << " random words ---" << std::endl;
+    // The heap policy comes last since the many small chunks it frees make the
+    // next allocations of the process slower.
+    const std::vector<std::pair<std::string, word_dict::memory_policy>> &policies = {
+        {"arena", word_dict::memory_policy::arena},
+        {"pool ", word_dict::memory_policy::pool},
+        {"heap ", word_dict::memory_policy::heap},
+    };
+    for(const auto &policy : policies) {
+        std::unique_ptr<word_dict> policy_dict(new word_dict(policy.second));
+        const double build_ms = time_ms([&]() {
+            for(const std::string &word : words) {
+                policy_dict->add_word(word);
+            }
+        });
+        const double destroy_ms = time_ms([&]() { policy_dict.reset(); });
+        std::cout << policy.first << ": build " << build_ms << " ms, destroy " << destroy_ms << " ms" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "--- Fetch words ---" << std::endl;
+    std::vector<std::string> fetched_words;
+    size_t nb_iterated_chars = 0;
+    std::cout << "fetch_words():          " << time_ms([&]() { dict.fetch_words(fetched_words); }) << " ms" << std::endl;
+    std::cout << "iterator:               " << time_ms([&]() {
+        for(const std::string &word : dict) {
+            nb_iterated_chars += word.length();
+        }
+    }) << " ms" << std::endl;
+    std::cout << "fetch_words_parallel(): " << time_ms([&]() { dict.fetch_words_parallel(fetched_words); }) << " ms" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "--- Scan random text ---" << std::endl;
+    string_dict_scanner scanner = dict.scanner();
+    for(unsigned int i = 0; i <= 1; i++) {
+        const size_t text_length = i == 0 ? 1 << 22 : 1 << 16; // approximate scans are much slower
+        const std::string text = generate_words(1, text_length, text_length, "abcdefghij ", 3).front();
+        size_t nb_occurrences = 0;
+        scanner.reset(i);
+        const double scan_ms = time_ms([&]() {
+            scanner.feed(text, [&nb_occurrences](const string_dict_scanner::occurrence &) {
+                nb_occurrences++;
+            });
+        });
+        std::cout << "at most " << i << " edits: " << scan_ms << " ms ("
+                  << text.length() / 1000.0 / scan_ms << " MB/s, "
+                  << nb_occurrences << " occurrences)" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "--- Match " << nb_words << " words exactly ---" << std::endl;
+    word_dict frozen_dict;
+    frozen_dict.add_words(words);
+    std::cout << "freeze(): " << time_ms([&]() { frozen_dict.freeze(); }) << " ms" << std::endl;
+    const std::vector<std::string> &random_words = generate_words(nb_words, 1, 12, "abcdefghij", 7);
+    for(const auto &tested_words : {std::make_pair("added ", &words), std::make_pair("random", &random_words)}) {
+        size_t nb_found = 0;
+        size_t nb_found_by_hash = 0;
+        const double tree_ms = time_ms([&]() {
+            for(const std::string &word : *tested_words.second) {
+                nb_found += dict.contains(word) ? 1 : 0;
+            }
+        });
+        const double hash_ms = time_ms([&]() {
+            for(const std::string &word : *tested_words.second) {
+                nb_found_by_hash += frozen_dict.contains(word) ? 1 : 0;
+            }
+        });
+        std::cout << tested_words.first << " words   tree: " << tree_ms << " ms"
+                  << " | perfect hash: " << hash_ms << " ms"
+                  << " | found: " << nb_found << "/" << nb_found_by_hash << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "--- Match " << nb_queries << " random words ---" << std::endl;
+    for(unsigned int i = 0; i <= budget_max; i++) {
+        compare_traversals("subst-match(" + std::to_string(i) + ")", queries,
+            [&](const std::string &word, string_dict_utils::traversal strategy) {
+                return dict.match_word_allow_substitution(word, i, strategy);
+            }
+        );
+    }
+    for(unsigned int i = 0; i <= budget_max; i++) {
+        compare_traversals("leven-match(" + std::to_string(i) + ")", queries,
+            [&](const std::string &word, string_dict_utils::traversal strategy) {
+                return dict.match_word_levenshtein_distance(word, i, strategy);
+            }
+        );
+    }
+
+    std::cout << std::endl;
+    std::cout << "--- Match " << nb_queries << " random words sharing prefixes ---" << std::endl;
+    std::vector<std::string> prefixed_queries;
+    for(const std::string &suffix : generate_words(nb_queries, 0, 3, "abcdefghij", 4)) {
+        prefixed_queries.push_back(queries.at(prefixed_queries.size() / 8) + suffix); // 8 queries per prefix
+    }
+    for(unsigned int i = 0; i <= budget_max; i++) {
+        size_t nb_matched = 0;
+        size_t nb_same_closest_words = 0;
+        std::vector<std::string> closest_words;
+        const double one_by_one_ms = time_ms([&]() {
+            for(const std::string &word : prefixed_queries) {
+                nb_matched += dict.match_word_levenshtein_distance(word, i).success ? 1 : 0;
+            }
+        });
+        const double closest_ms = time_ms([&]() {
+            for(const std::string &word : prefixed_queries) {
+                closest_words.push_back(dict.match_closest_word_levenshtein_distance(word, i).matched);
+            }
+        });
+        const double batch_ms = time_ms([&]() {
+            const std::vector<string_dict_utils::match_data> &matches = dict.match_words_levenshtein_distance(prefixed_queries, i);
+            for(size_t j = 0; j < matches.size(); j++) {
+                nb_same_closest_words += matches[j].matched == closest_words[j] ? 1 : 0;
+            }
+        });
+        std::cout << "leven-match(" << i << ")   one by one: " << one_by_one_ms << " ms"
+                  << " | closest one by one: " << closest_ms << " ms"
+                  << " | closest by batch: " << batch_ms << " ms"
+                  << " | matched: " << nb_matched << "/" << prefixed_queries.size()
+                  << " | same closest: " << nb_same_closest_words << "/" << prefixed_queries.size() << std::endl;
+    }
+
+    std::cout << std::endl;
+    std::cout << "--- Match " << nb_queries << " long random words with large budgets ---" << std::endl;
+    word_dict long_dict;
+    long_dict.add_words(generate_words(nb_words, 12, 20, "abcdefghijklmnopqrstuvwxyz", 5));
+    const std::vector<std::string> &long_queries = generate_words(nb_queries, 12, 20, "abcdefghijklmnopqrstuvwxyz", 6);
+    typedef struct {
+        double tree_ms;       // first word found by the tree traversal
+        double closest_ms;    // closest word, without q-gram index
+        size_t nb_matched;
+        std::vector<std::string> closest_words;
+    } long_result;
+    std::vector<long_result> long_results; // per budget
+    for(unsigned int i = 3; i <= budget_max; i++) {
+        long_result result {0, 0, 0, {}};
+        result.tree_ms = time_ms([&]() {
+            for(const std::string &word : long_queries) {
+                result.nb_matched += long_dict.match_word_levenshtein_distance(word, i).success ? 1 : 0;
+            }
+        });
+        result.closest_ms = time_ms([&]() {
+            for(const std::string &word : long_queries) {
+                result.closest_words.push_back(long_dict.match_closest_word_levenshtein_distance(word, i).matched);
+            }
+        });
+        long_results.push_back(result);
+    }
+    std::cout << "build_qgram_index(): " << time_ms([&]() { long_dict.build_qgram_index(); }) << " ms" << std::endl;
+    for(unsigned int i = 3; i <= budget_max; i++) {
+        const long_result &result = long_results[i-3];
+        size_t nb_same_closest_words = 0;
+        const double index_ms = time_ms([&]() {
+            for(size_t j = 0; j < long_queries.size(); j++) {
+                const std::string &matched = long_dict.match_closest_word_levenshtein_distance(long_queries[j], i).matched;
+                nb_same_closest_words += matched == result.closest_words[j] ? 1 : 0;
+            }
+        });
+        std::cout << "leven-match(" << i << ")   tree: " << result.tree_ms << " ms"
+                  << " | closest: " << result.closest_ms << " ms"
+                  << " | closest with q-gram index: " << index_ms << " ms"
+                  << " | matched: " << result.nb_matched << "/" << long_queries.size()
+                  << " | same closest: " << nb_same_closest_words << "/" << long_queries.size() << std::endl;
+    }
+    // Words closest within budget_max edits remain the closest ones without
+    // budget, and other words cost more (costs must not overflow).
+    const unsigned int budget_unbounded = std::numeric_limits<unsigned int>::max();
+    size_t nb_consistent_matches = 0;
+    const double unbounded_ms = time_ms([&]() {
+        for(size_t j = 0; j < long_queries.size(); j++) {
+            const string_dict_utils::match_data &match = long_dict.match_closest_word_levenshtein_distance(long_queries[j], budget_unbounded);
+            const std::string &closest_word = long_results.back().closest_words[j];
+            nb_consistent_matches += (closest_word.empty() ? match.cost > budget_max : match.matched == closest_word) ? 1 : 0;
+        }
+    });
+    std::cout << "leven-match(" << budget_unbounded << ")   closest: " << unbounded_ms << " ms"
+              << " | consistent with leven-match(" << budget_max << "): " << nb_consistent_matches << "/" << long_queries.size() << std::endl;
+    std::cout << long_dict.match_closest_word_levenshtein_distance("abcdefghijklmnopqrstuvwxyz", budget_unbounded).full_str() << std::endl;
+
+    std::cout << std::endl;
+    std::cout << "--- Match " << nb_queries << " misspelled frequent words ---" << std::endl;
+    word_dict ordered_dict;
+    ordered_dict.add_words(words);
+    const std::vector<std::pair<std::string, std::string>> &misspelled_words = generate_misspelled_words(words, nb_queries, "abcdefghij", 8);
+    const auto &match_misspelled_words = [&](const std::string &order_name) {
+        size_t nb_intended = 0;
+        size_t nb_intended_by_subst = 0;
+        const double leven_ms = time_ms([&]() {
+            for(const auto &word : misspelled_words) {
+                nb_intended += ordered_dict.match_word_levenshtein_distance(word.second, 1).matched == word.first + word_dict::end_of_word_marker() ? 1 : 0;
+            }
+        });
+        const double subst_ms = time_ms([&]() {
+            for(const auto &word : misspelled_words) {
+                nb_intended_by_subst += ordered_dict.match_word_allow_substitution(word.second, 1).matched == word.first + word_dict::end_of_word_marker() ? 1 : 0;
+            }
+        });
+        std::cout << order_name << "   leven-match(1): " << leven_ms << " ms, " << nb_intended << " intended"
+                  << " | subst-match(1): " << subst_ms << " ms, " << nb_intended_by_subst << " intended" << std::endl;
+    };
+    match_misspelled_words("tree order    ");
+    ordered_dict.set_expected_char_first(true);
+    match_misspelled_words("expected first");
+    ordered_dict.set_expected_char_first(false);
+    ordered_dict.freeze(); // hits are counted by word identifier
+    ordered_dict.record_hits(true);
+    for(const auto &word : generate_misspelled_words(words, 10 * nb_queries, "abcdefghij", 9)) {
+        ordered_dict.match_word_exactly(word.first); // the intended words are usually typed correctly
+    }
+    ordered_dict.record_hits(false);
+    std::cout << "relayout(): " << time_ms([&]() { ordered_dict.relayout(); }) << " ms" << std::endl;
+    match_misspelled_words("hit counts    ");
+    ordered_dict.set_expected_char_first(true);
+    match_misspelled_words("both          ");
+
+    std::cout << std::endl;
+    std::cout << "--- Memory of " << nb_words << " words ---" << std::endl;
+    ordered_dict.build_qgram_index();
+    for(const auto &memory_dict : {std::make_pair("plain             ", &dict), std::make_pair("frozen and indexed", &ordered_dict)}) {
+        const word_dict::memory_footprint &footprint = memory_dict.second->memory_counters();
+        const word_dict::memory_footprint &stats = memory_dict.second->memory_stats();
+        std::cout << memory_dict.first << "   tree: " << footprint.reserved_bytes
+                  << " | q-gram index: " << footprint.qgram_index_bytes
+                  << " | perfect hash: " << footprint.perfect_hash_bytes
+                  << " | child order: " << footprint.child_order_bytes
+                  << " | hit counts: " << footprint.hit_count_bytes
+                  << " | word weights: " << footprint.word_weight_bytes
+                  << " | total: " << footprint.total_bytes() << " bytes"
+                  << " | same stats: " << (stats.total_bytes() == footprint.total_bytes() ? "yes" : "no") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include "word_dict.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+
+/// Returns randomly generated words (the same words for the same seed).
+std::vector<std::string> generate_words(size_t count,
+                                        size_t length_min,
+                                        size_t length_max,
+                                        const std::string &alphabet,
+                                        unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<size_t> length_distribution(length_min, length_max);
+    std::uniform_int_distribution<size_t> char_distribution(0, alphabet.length() - 1);
+
+    std::vector<std::string> words;
+    words.reserve(count);
+    for(size_t i = 0; i < count; i++) {
+        std::string word(length_distribution(generator), '\0');
+        for(char &c : word) {
+            c = alphabet.at(char_distribution(generator));
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+/// Returns pairs of a word picked among the given (non-empty) ones with a
+/// skewed distribution (the first words being the most frequent) and the same
+/// word with one character substituted.
+std::vector<std::pair<std::string, std::string>> generate_misspelled_words(const std::vector<std::string> &words,
+                                                                           size_t count,
+                                                                           const std::string &alphabet,
+                                                                           unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::geometric_distribution<size_t> word_distribution(0.05);
+    std::uniform_int_distribution<size_t> char_distribution(0, alphabet.length() - 1);
+
+    std::vector<std::pair<std::string, std::string>> misspelled_words;
+    misspelled_words.reserve(count);
+    for(size_t i = 0; i < count; i++) {
+        const std::string &word = words.at(std::min(word_distribution(generator), words.size() - 1));
+        std::string misspelled_word = word;
+        char &c = misspelled_word.at(std::uniform_int_distribution<size_t>(0, word.length() - 1)(generator));
+        while(c == word.at(&c - &misspelled_word[0])) {
+            c = alphabet.at(char_distribution(generator));
+        }
+        misspelled_words.push_back(std::make_pair(word, misspelled_word));
+    }
+    return misspelled_words;
+}
+
+/// Returns the time (in milliseconds) taken by the given function.
+double time_ms(const std::function<void ()> &function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// Runs the given matching function on all words, once per traversal strategy,
+/// and prints the time taken by each strategy along with the number of matched
+/// words. The number of words for which both strategies disagree on success is
+/// printed as well (it must be 0).
+void compare_traversals(const std::string &name,
+                        const std::vector<std::string> &words,
+                        const std::function<string_dict_utils::match_data (const std::string &,
+                                                                           string_dict_utils::traversal)> &match)
+{
+    std::vector<bool> dfs_successes;
+    std::vector<bool> level_successes;
+    const double dfs_ms = time_ms([&]() {
+        for(const std::string &word : words) {
+            dfs_successes.push_back(match(word, string_dict_utils::traversal::depth_first).success);
+        }
+    });
+    const double level_ms = time_ms([&]() {
+        for(const std::string &word : words) {
+            level_successes.push_back(match(word, string_dict_utils::traversal::level_synchronous).success);
+        }
+    });
+
+    size_t nb_matched = 0;
+    size_t nb_mismatches = 0;
+    for(size_t i = 0; i < words.size(); i++) {
+        nb_matched += dfs_successes[i] ? 1 : 0;
+        nb_mismatches += dfs_successes[i] != level_successes[i] ? 1 : 0;
+    }
+
+    std::cout << std::left << std::setw(16) << name
+              << " depth-first: " << std::right << std::setw(10) << std::fixed << std::setprecision(2) << dfs_ms << " ms"
+              << " | level-synchronous: " << std::setw(10) << level_ms << " ms"
+              << " | matched: " << nb_matched << "/" << words.size()
+              << " | mismatches: " << nb_mismatches
+              << std::endl;
+}
+
+#endif // BENCH_UTILS_H
@@ -0,0 +1,148 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "fuzzy_session.h"
+
+#include "word_dict.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+fuzzy_session::fuzzy_session(const word_dict &dict, unsigned int edit_max)
+    : m_columns(dict.m_words, edit_max)
+{
+}
+
+void fuzzy_session::push_char(char c)
+{
+    m_columns.push(c);
+}
+
+void fuzzy_session::pop_char()
+{
+    m_columns.pop();
+}
+
+std::vector<fuzzy_session::candidate> fuzzy_session::matches(size_t max_count) const
+{
+    // The cost of an active node is the Levenshtein distance between the word
+    // searched and the string read to reach the node, so words matched are
+    // read from the active nodes having an end of word marker child.
+    std::vector<candidate> candidates;
+    for(const string_dict_lev_columns::entry &curr : m_columns.top()) {
+        if(curr.node->child_ptr(word_dict::end_of_word_marker())) {
+            candidates.push_back({m_columns.path_string(curr.path), curr.cost});
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const candidate &a, const candidate &b) {
+        return a.cost != b.cost ? a.cost < b.cost : string_dict_utils::precedes_in_tree(a.word, b.word);
+    });
+    if(candidates.size() > max_count) {
+        candidates.resize(max_count);
+    }
+    return candidates;
+}
+
+std::vector<fuzzy_session::candidate> fuzzy_session::prefix_matches(size_t max_count) const
+{
+    // Logic: the distance of a word is the lowest cost of the active nodes
+    //        on its path. For each cost c (by increasing cost), the words of
+    //        distance c are read from the subtrees of the active nodes of
+    //        cost c having no active ancestor of cost c or less (the minimal
+    //        nodes, whose subtrees are disjoint), skipping the subtrees of
+    //        the active nodes of lower cost (their words were read already).
+    //        Minimal nodes are visited in the order of their strings, and
+    //        their subtrees in the order of tree, so words of equal distance
+    //        come in the order of tree.
+    //
+    // Complexity: O(number_of_active_nodes * depth + number_of_nodes_read)
+    //             where number_of_nodes_read is the number of nodes in the
+    //             subtrees read until max_count words are found, each node
+    //             being read once at most.
+
+    typedef dtree<char>::node_t node_t;
+    const std::vector<string_dict_lev_columns::entry> &entries = m_columns.top();
+    std::unordered_map<unsigned int, unsigned int> path_costs;
+    std::unordered_map<const node_t*, unsigned int> node_costs;
+    unsigned int cost_max {0};
+    for(const string_dict_lev_columns::entry &curr : entries) {
+        path_costs.emplace(curr.path, curr.cost);
+        node_costs.emplace(curr.node, curr.cost);
+        cost_max = std::max(cost_max, curr.cost);
+    }
+
+    std::vector<std::vector<std::pair<std::string, const node_t*>>> minimal_nodes(cost_max + 1); // per cost
+    for(const string_dict_lev_columns::entry &curr : entries) {
+        if(curr.path != 0 && m_columns.path_char(curr.path) == word_dict::end_of_word_marker()) {
+            continue; // not a prefix of words
+        }
+        bool is_minimal {true};
+        for(unsigned int path = curr.path; path != 0 && is_minimal;) {
+            path = m_columns.path_parent(path);
+            const auto it = path_costs.find(path);
+            is_minimal = it == path_costs.end() || it->second > curr.cost;
+        }
+        if(is_minimal) {
+            minimal_nodes[curr.cost].push_back(std::make_pair(m_columns.path_string(curr.path), curr.node));
+        }
+    }
+
+    std::vector<candidate> candidates;
+    std::vector<std::pair<node_t::const_iterator, node_t::const_iterator>> unvisited_children;
+    for(unsigned int cost = 0; cost < minimal_nodes.size() && candidates.size() < max_count; cost++) {
+        auto &nodes = minimal_nodes[cost];
+        std::sort(nodes.begin(), nodes.end(), [](const std::pair<std::string, const node_t*> &a,
+                                                 const std::pair<std::string, const node_t*> &b) {
+            return string_dict_utils::precedes_in_tree(a.first, b.first);
+        });
+
+        for(size_t i = 0; i < nodes.size() && candidates.size() < max_count; i++) {
+            std::string word = nodes[i].first;
+            unvisited_children.assign(1, std::make_pair(nodes[i].second->begin(), nodes[i].second->end()));
+            while(!unvisited_children.empty() && candidates.size() < max_count) {
+                auto &children = unvisited_children.back();
+                if(children.first == children.second) {
+                    unvisited_children.pop_back();
+                    if(!unvisited_children.empty()) {
+                        word.pop_back();
+                    }
+                    continue;
+                }
+                const auto it = children.first++;
+                if(it->first == word_dict::end_of_word_marker()) {
+                    candidates.push_back({word, cost});
+                    continue;
+                }
+                const auto node_cost = node_costs.find(&it->second);
+                if(node_cost != node_costs.end() && node_cost->second < cost) {
+                    continue; // words read at a lower cost
+                }
+                word += it->first;
+                unvisited_children.push_back(std::make_pair(it->second.begin(), it->second.end()));
+            }
+        }
+    }
+    return candidates;
+}
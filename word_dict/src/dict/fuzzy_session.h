@@ -0,0 +1,72 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef FUZZY_SESSION_H
+#define FUZZY_SESSION_H
+
+#include "string_dict_lev_columns.h"
+
+#include <cstdint>
+
+class word_dict;
+
+/// Incremental ("as-you-type") fuzzy search in a dictionary of words: the word
+/// searched is edited one character at a time at its end, and the words within
+/// a given Levenshtein distance of it can be queried after each edit. Each
+/// edit costs time proportional to the number of tree nodes within that
+/// distance (see string_dict_lev_columns) rather than to the length of the
+/// word searched. The dictionary must outlive the session and must not be
+/// modified meanwhile.
+class fuzzy_session
+{
+public:
+    typedef struct {
+        std::string word;  // word in dictionary (without end of word marker)
+        unsigned int cost; // Levenshtein distance (see matches() and prefix_matches())
+    } candidate;
+
+public:
+    explicit fuzzy_session(const word_dict &dict, unsigned int edit_max);
+
+    void push_char(char c);
+    void pop_char();
+
+    /// Returns the word searched.
+    const std::string& word() const { return m_columns.str(); }
+
+    /// Returns at most max_count words whose Levenshtein distance to the word
+    /// searched doesn't exceed edit_max, by increasing distance then in the
+    /// order of the dictionary (see word_dict::begin()).
+    std::vector<candidate> matches(size_t max_count = SIZE_MAX) const;
+    /// Returns at most max_count words having a prefix whose Levenshtein
+    /// distance to the word searched doesn't exceed edit_max, by increasing
+    /// distance (the lowest distance among prefixes) then in the order of the
+    /// dictionary. Only the words returned are read from the dictionary.
+    std::vector<candidate> prefix_matches(size_t max_count = SIZE_MAX) const;
+
+private:
+    string_dict_lev_columns m_columns;
+};
+
+#endif // FUZZY_SESSION_H
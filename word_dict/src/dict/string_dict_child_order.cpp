@@ -0,0 +1,135 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "string_dict_child_order.h"
+
+#include "string_dict_utils.h"
+
+#include <algorithm>
+#include <tuple>
+
+void string_dict_child_order::relayout(const dtree<char> &tree,
+                                       const std::function<double (const std::string &)> &string_weight)
+{
+    // Logic: tree is traversed depth-first with a stack of frames (one per
+    //        node along the current path), and the weight of a node (total
+    //        weight of the strings in its subtree) is known once all its
+    //        children are visited. At that point its children are sorted by
+    //        decreasing weight and saved in the layout in case their order
+    //        differs from the order of tree.
+    //
+    // Complexity: O(number_of_nodes_in_tree * log(n)) where n = number of
+    //             children of the node with the widest offspring in tree.
+
+    typedef std::tuple<double, char, const dtree<char>::node_t*> weighted_child;
+    typedef struct {
+        const dtree<char>::node_t *node;
+        dtree<char>::node_t::const_iterator it; // next child to visit
+        char c;                                 // character read to reach node
+        double weight;                          // total weight of the strings read from the visited children
+        std::vector<weighted_child> children;   // visited children
+    } frame;
+
+    m_layout.clear();
+    m_relaid_out = true;
+
+    std::string read_string;
+    std::vector<frame> unvisited_frames;
+    unvisited_frames.push_back(frame {&tree.root(), tree.root().begin(), '\0', 0, {}});
+    while(!unvisited_frames.empty()) {
+        frame &top = unvisited_frames.back();
+
+        // Visit the next child of node.
+        if(top.it != top.node->end()) {
+            const char c = top.it->first;
+            const dtree<char>::node_t *child = &top.it->second;
+            top.it++;
+            if(c == string_dict_utils::tree_end_of_string_marker) { // leaf
+                const double weight = string_weight(read_string);
+                top.weight += weight;
+                top.children.emplace_back(weight, c, child);
+            }
+            else {
+                read_string.push_back(c);
+                unvisited_frames.push_back(frame {child, child->begin(), c, 0, {}});
+            }
+            continue;
+        }
+
+        // All children of node are visited.
+        std::vector<weighted_child> &children = top.children;
+        std::stable_sort(children.begin(), children.end(), [](const weighted_child &a, const weighted_child &b) {
+            return std::get<0>(a) > std::get<0>(b);
+        });
+        const bool reordered = !std::is_sorted(children.begin(), children.end(), [](const weighted_child &a, const weighted_child &b) {
+            return std::get<1>(a) < std::get<1>(b);
+        });
+        if(reordered) {
+            children_t &layout = m_layout[top.node];
+            for(const weighted_child &child : children) {
+                layout.push_back(std::make_pair(std::get<1>(child), std::get<2>(child)));
+            }
+        }
+
+        const double weight = top.weight;
+        const char c = top.c;
+        const dtree<char>::node_t *node = top.node;
+        unvisited_frames.pop_back();
+        if(!unvisited_frames.empty()) {
+            read_string.pop_back();
+            unvisited_frames.back().weight += weight;
+            unvisited_frames.back().children.emplace_back(weight, c, node);
+        }
+    }
+
+    m_bytes = string_dict_utils::allocated_bytes(m_layout);
+    for(const auto &layout : m_layout) {
+        m_bytes += string_dict_utils::allocated_bytes(layout.second);
+    }
+}
+
+void string_dict_child_order::fill_children(const dtree<char>::node_t &node,
+                                            char expected_char,
+                                            children_t &children) const
+{
+    const auto layout_it = m_layout.empty() ? m_layout.end() : m_layout.find(&node);
+    if(layout_it != m_layout.end()) {
+        children = layout_it->second;
+    }
+    else {
+        children.clear();
+        for(auto it = node.begin(); it != node.end(); it++) {
+            children.push_back(std::make_pair(it->first, &it->second));
+        }
+    }
+
+    if(m_expected_char_first) {
+        const auto expected_it = std::find_if(children.begin(), children.end(), [expected_char](const children_t::value_type &child) {
+            return child.first == expected_char;
+        });
+        if(expected_it != children.end()) {
+            std::rotate(children.begin(), expected_it, expected_it + 1);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef STRING_DICT_CHILD_ORDER_H
+#define STRING_DICT_CHILD_ORDER_H
+
+#include "dtree.hpp"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Order in which the depth-first fuzzy string-matching-algorithms of
+/// string_dict_utils visit the children of the nodes of a tree of characters.
+/// Since these algorithms stop at the first string matched, the order decides
+/// which string is matched and how much of tree is read before. Children are
+/// visited in the order of tree (i.e. by character) unless they are ordered by
+/// decreasing weight of the strings in their subtree (see relayout()), and the
+/// child read from the character expected at the current position of the
+/// given string can be visited first. The order is a side
+/// layout referring to the nodes of tree, so it must be cleared or rebuilt
+/// whenever strings are added to tree.
+class string_dict_child_order
+{
+public:
+    typedef std::vector<std::pair<char, const dtree<char>::node_t*>> children_t; // children in visit order
+
+public:
+    explicit string_dict_child_order(bool expected_char_first = false)
+        : m_expected_char_first(expected_char_first) {}
+
+    /// Orders the children of each node of tree by decreasing total weight of
+    /// the strings in their subtree (children of equal weight remaining in the
+    /// order of tree). The weight of a string (given without the
+    /// tree_end_of_string_marker) is returned by string_weight. Tree is
+    /// traversed without recursion.
+    void relayout(const dtree<char> &tree,
+                  const std::function<double (const std::string &)> &string_weight);
+    /// Restores the order of tree.
+    void clear() { m_layout.clear(); m_relaid_out = false; m_bytes = 0; }
+
+    bool expected_char_first() const { return m_expected_char_first; }
+    void set_expected_char_first(bool enabled) { m_expected_char_first = enabled; }
+
+    /// Tells whether neither relayout() nor set_expected_char_first() were
+    /// called, in which case there is no point passing this order to
+    /// string_dict_utils (whose own default order is faster).
+    bool is_default() const { return !m_relaid_out && !m_expected_char_first; }
+    bool is_relaid_out() const { return m_relaid_out; }
+    /// Returns the estimated number of bytes allocated for the order.
+    size_t bytes() const { return m_bytes; }
+
+    /// Fills children with the children of node in visit order, given the
+    /// character expected at the position of the string being matched.
+    void fill_children(const dtree<char>::node_t &node,
+                       char expected_char,
+                       children_t &children) const;
+
+private:
+    bool m_expected_char_first;
+    bool m_relaid_out {false};
+    std::unordered_map<const dtree<char>::node_t*, children_t> m_layout; // only for nodes whose children are reordered
+    size_t m_bytes {0};
+};
+
+#endif // STRING_DICT_CHILD_ORDER_H
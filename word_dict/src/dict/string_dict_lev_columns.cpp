@@ -0,0 +1,179 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "string_dict_lev_columns.h"
+
+#include <algorithm>
+#include <limits>
+
+// Logic: the Levenshtein distance matrix between a string read from tree and
+//        the string built is filled column by column (one column per
+//        character of the string built) instead of row by row as in
+//        string_dict_utils::match_string_levenshtein_distance(). Because tree
+//        nodes are shared between strings read from tree, a column holds one
+//        cost per tree node: Cost[node] is the Levenshtein distance between
+//        the string read to reach node and the string built. When character
+//        c is appended to the string built, the new column is computed from
+//        the previous one as follows:
+//            Cost[node] = min(
+//                Prev[node] + 1,                                     // c is deleted
+//                Prev[parent] + (c == char_read_to_reach_node ? 0 : 1), // c is substituted (or kept)
+//                Cost[parent] + 1                                    // char_read_to_reach_node is inserted
+//            )
+//        The first column is Cost[node] = depth_of_node. Since costs never
+//        decrease from one column to the next along a path, nodes whose cost
+//        exceeds edit_max are dropped: their children can only be reached
+//        again from active nodes. The last rule above (insertions) is applied
+//        by visiting new active nodes by increasing cost.
+//
+// Complexity: O(number_of_active_nodes * n) per column where n is the number
+//             of children of the node with the widest offspring in tree.
+
+namespace {
+
+// Budgets are clamped so that costs never overflow (no cost can exceed the
+// length of the longest string in tree plus the length of the string built
+// anyway).
+const unsigned int edit_max_limit {std::numeric_limits<unsigned int>::max() / 2};
+
+} // namespace
+
+string_dict_lev_columns::string_dict_lev_columns(const dtree<char> &tree, unsigned int edit_max)
+    : m_edit_max(std::min(edit_max, edit_max_limit))
+{
+    m_paths.push_back(std::make_pair(0u, '\0')); // path of root
+    m_node_paths.emplace(&tree.root(), 0);
+
+    m_columns.emplace_back();
+    relax_cost(m_columns.back(), &tree.root(), 0, 0);
+    close_column(m_columns.back());
+}
+
+void string_dict_lev_columns::push(char c)
+{
+    m_columns.emplace_back();
+    const std::vector<entry> &prev_column = m_columns[m_columns.size() - 2];
+    std::vector<entry> &column = m_columns.back();
+
+    for(const entry &prev : prev_column) {
+        relax_cost(column, prev.node, prev.path, prev.cost + 1);
+
+        if(prev.cost == m_edit_max) { // only characters identical to c are affordable
+            const auto it = prev.node->lower_bound(c);
+            if(it != prev.node->end() && it->first == c) {
+                relax_cost(column, &it->second, path_of_child(prev.path, &it->second, c), prev.cost);
+            }
+            continue;
+        }
+        for(auto it = prev.node->begin(); it != prev.node->end(); it++) {
+            relax_cost(column,
+                       &it->second,
+                       path_of_child(prev.path, &it->second, it->first),
+                       prev.cost + (it->first == c ? 0 : 1));
+        }
+    }
+    close_column(column);
+
+    m_string += c;
+}
+
+void string_dict_lev_columns::pop()
+{
+    if(m_columns.size() > 1) {
+        m_columns.pop_back();
+        m_string.pop_back();
+    }
+}
+
+std::string string_dict_lev_columns::path_string(unsigned int path) const
+{
+    std::string str;
+    for(; path != 0; path = m_paths[path].first) {
+        str += m_paths[path].second;
+    }
+    return std::string(str.rbegin(), str.rend());
+}
+
+unsigned int string_dict_lev_columns::path_of_child(unsigned int parent_path,
+                                                    const dtree<char>::node_t *child,
+                                                    char c)
+{
+    const auto inserted = m_node_paths.emplace(child, m_paths.size());
+    if(inserted.second) {
+        m_paths.push_back(std::make_pair(parent_path, c));
+    }
+    return inserted.first->second;
+}
+
+void string_dict_lev_columns::relax_cost(std::vector<entry> &column,
+                                         const dtree<char>::node_t *node,
+                                         unsigned int path,
+                                         unsigned int cost)
+{
+    if(cost > m_edit_max) {
+        return;
+    }
+
+    const auto inserted = m_entry_indexes.emplace(node, column.size());
+    const size_t index = inserted.first->second;
+    if(inserted.second) {
+        column.push_back({node, path, cost});
+    }
+    else if(cost < column[index].cost) {
+        column[index].cost = cost;
+    }
+    else {
+        return;
+    }
+    if(cost >= m_entries_by_cost.size()) {
+        m_entries_by_cost.resize(cost + 1); // buckets only cover the costs met so far
+    }
+    m_entries_by_cost[cost].push_back(index);
+}
+
+void string_dict_lev_columns::close_column(std::vector<entry> &column)
+{
+    // Entries are visited by increasing cost, and skipped when their cost has
+    // decreased since they were saved (they are visited with the lower cost).
+    // Buckets are read by index since relaxing costs can add buckets.
+    for(unsigned int cost = 0; cost < m_edit_max && cost < m_entries_by_cost.size(); cost++) {
+        for(size_t i = 0; i < m_entries_by_cost[cost].size(); i++) {
+            const entry curr = column[m_entries_by_cost[cost][i]];
+            if(curr.cost != cost) {
+                continue;
+            }
+            for(auto it = curr.node->begin(); it != curr.node->end(); it++) {
+                relax_cost(column,
+                           &it->second,
+                           path_of_child(curr.path, &it->second, it->first),
+                           cost + 1);
+            }
+        }
+    }
+
+    for(std::vector<size_t> &indexes : m_entries_by_cost) {
+        indexes.clear();
+    }
+    m_entry_indexes.clear();
+}
@@ -0,0 +1,98 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef STRING_DICT_LEV_COLUMNS_H
+#define STRING_DICT_LEV_COLUMNS_H
+
+#include "dtree.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Columns of the Levenshtein distance matrices between all strings in a tree
+/// of characters (see string_dict_utils) and a string built one character at
+/// a time. A column is pushed for each character appended to the string and
+/// popped when the character is removed, so strings sharing a prefix share the
+/// columns computed for that prefix. Each column only holds the tree nodes
+/// whose cost doesn't exceed a given limit (the active nodes), so pushing a
+/// column costs time proportional to the number of active nodes rather than
+/// to the length of the string. See comments on the algorithm in *.cpp file.
+class string_dict_lev_columns
+{
+public:
+    typedef struct {
+        const dtree<char>::node_t *node; // active node
+        unsigned int path;               // path to node (see path_string())
+        unsigned int cost;               // Levenshtein distance between string read to reach node and string built
+    } entry;
+
+public:
+    /// The tree must outlive this object and must not be modified meanwhile.
+    /// Budgets above std::numeric_limits<unsigned int>::max() / 2 are clamped
+    /// to it (larger budgets cannot make a difference).
+    explicit string_dict_lev_columns(const dtree<char> &tree, unsigned int edit_max);
+
+    /// Appends a character to the string built and pushes its column.
+    void push(char c);
+    /// Removes the last character from the string built and pops its column.
+    void pop();
+
+    /// Returns the string built so far.
+    const std::string& str() const { return m_string; }
+    /// Returns the active nodes for the string built so far.
+    const std::vector<entry>& top() const { return m_columns.back(); }
+
+    /// Returns the string read from tree to reach the node of an entry.
+    std::string path_string(unsigned int path) const;
+    /// Returns the last character of that same string.
+    char path_char(unsigned int path) const { return m_paths[path].second; }
+    /// Returns the path to the parent of the node reached by the given path
+    /// (the path of root is 0, and is its own parent).
+    unsigned int path_parent(unsigned int path) const { return m_paths[path].first; }
+
+    unsigned int edit_max() const { return m_edit_max; }
+
+private:
+    unsigned int path_of_child(unsigned int parent_path, const dtree<char>::node_t *child, char c);
+    void relax_cost(std::vector<entry> &column,
+                    const dtree<char>::node_t *node,
+                    unsigned int path,
+                    unsigned int cost);
+    void close_column(std::vector<entry> &column);
+
+private:
+    const unsigned int m_edit_max;
+    std::string m_string;
+    std::vector<std::vector<entry>> m_columns;
+
+    std::vector<std::pair<unsigned int, char>> m_paths; // parent path and character read, for each path
+    std::unordered_map<const dtree<char>::node_t*, unsigned int> m_node_paths;
+
+    // Working data for the column being computed.
+    std::unordered_map<const dtree<char>::node_t*, size_t> m_entry_indexes;
+    std::vector<std::vector<size_t>> m_entries_by_cost;
+};
+
+#endif // STRING_DICT_LEV_COLUMNS_H
@@ -0,0 +1,246 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "string_dict_perfect_hash.h"
+
+#include "string_dict_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Logic: every string is hashed once into a 64-bit value h. The hash
+//        function is then made of levels, each level being a bit array:
+//            - the strings of level 0 (all strings) are hashed (from h and a
+//              seed specific to the level) into a bit array of gamma bits
+//              per string. A bit is set when exactly one string falls into
+//              it, and those strings are done with.
+//            - the strings which fell into the same bit as another one are
+//              hashed into the next level the same way, and so on.
+//        A string in tree therefore falls into an unset bit at all levels but
+//        its own, where it falls into a set bit. The slot of the string is the
+//        number of bits set before its own in the concatenation of all levels
+//        (its rank), which is computed in O(1) from a precomputed count of
+//        bits set before each 64-bit word. So slots are numbered from 0 to
+//        number_of_strings-1 without gap (the hash function is minimal and
+//        perfect). The few strings still colliding after the last level (e.g.
+//        strings having the same value h) are stored in a hash map.
+//
+//        A string which is not in tree may fall into the set bit of another
+//        string, so the slot holds the value h of its string and the string
+//        looked up is accepted only if it has the same value. The strings
+//        in the hash map (a few, if any) are the only ones stored.
+//
+// Complexity: O(l) for hashing then O(1) on average (with gamma = 2, most
+//             strings are found at level 0 and the expected number of levels
+//             read is below 2) where l = length of the given string.
+//
+// Side notes: see (1) at the bottom of this file.
+
+namespace {
+
+const size_t max_nb_levels {32};
+
+// Finalizer of MurmurHash3 (bijective mixing of 64 bits).
+std::uint64_t mix_bits(std::uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+std::uint64_t hash_string(const char *str, size_t length)
+{
+    std::uint64_t h = mix_bits(0x9e3779b97f4a7c15ULL + length);
+    size_t i = 0;
+    for(; i + 8 <= length; i += 8) {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, str + i, 8);
+        h = mix_bits(h ^ chunk) * 0x9e3779b97f4a7c15ULL;
+    }
+    std::uint64_t chunk = 0;
+    std::memcpy(&chunk, str + i, length - i);
+    return mix_bits(h ^ chunk);
+}
+
+// Returns the bit into which a string hashed to h falls at the given level.
+size_t level_bit(std::uint64_t h, size_t level, size_t nb_bits)
+{
+    return mix_bits(h ^ ((level + 1) * 0x9e3779b97f4a7c15ULL)) % nb_bits;
+}
+
+unsigned int count_bits(std::uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    unsigned int count = 0;
+    for(; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+} // namespace
+
+const size_t string_dict_perfect_hash::npos {static_cast<size_t>(-1)};
+
+string_dict_perfect_hash::string_dict_perfect_hash(const dtree<char> &tree, double gamma)
+{
+    gamma = std::max(gamma, 1.0);
+
+    std::vector<std::uint64_t> hashes;
+    const string_dict_utils::string_iterator end;
+    for(string_dict_utils::string_iterator it(tree.root()); it != end; ++it) {
+        hashes.push_back(hash_string(it->data(), it->length() - 1)); // without tree_end_of_string_marker
+    }
+
+    // Build levels.
+    std::vector<std::uint32_t> level_ids(hashes.size()); // identifiers of the strings to place at the current level
+    for(std::uint32_t id = 0; id < level_ids.size(); id++) {
+        level_ids[id] = id;
+    }
+    std::vector<std::pair<size_t, std::uint32_t>> placed_ids; // bit (in all levels) and identifier of placed strings
+    std::vector<std::uint64_t> collided_bits;
+    for(size_t level = 0; level < max_nb_levels && !level_ids.empty(); level++) {
+        const size_t nb_words = (static_cast<size_t>(std::ceil(gamma * level_ids.size())) + 63) / 64;
+        const size_t nb_bits = nb_words * 64;
+        const size_t level_offset = m_bits.size();
+        m_level_offsets.push_back(level_offset);
+        m_bits.resize(level_offset + nb_words, 0);
+        collided_bits.assign(nb_words, 0);
+
+        std::uint64_t *bits = &m_bits[level_offset];
+        for(const std::uint32_t id : level_ids) {
+            const size_t bit = level_bit(hashes[id], level, nb_bits);
+            const std::uint64_t mask = 1ULL << (bit % 64);
+            if(bits[bit / 64] & mask) {
+                collided_bits[bit / 64] |= mask;
+            }
+            bits[bit / 64] |= mask;
+        }
+        size_t nb_next_ids = 0;
+        for(const std::uint32_t id : level_ids) {
+            const size_t bit = level_bit(hashes[id], level, nb_bits);
+            if(collided_bits[bit / 64] & (1ULL << (bit % 64))) {
+                level_ids[nb_next_ids++] = id; // string moves to next level
+            }
+            else {
+                placed_ids.push_back(std::make_pair(level_offset * 64 + bit, id));
+            }
+        }
+        for(size_t i = 0; i < nb_words; i++) {
+            bits[i] &= ~collided_bits[i];
+        }
+        level_ids.resize(nb_next_ids);
+    }
+    m_level_offsets.push_back(m_bits.size());
+
+    // Rank bits and fill slots.
+    m_ranks.resize(m_bits.size());
+    std::uint32_t rank = 0;
+    for(size_t i = 0; i < m_bits.size(); i++) {
+        m_ranks[i] = rank;
+        rank += count_bits(m_bits[i]);
+    }
+    m_hashes.resize(placed_ids.size());
+    m_ids.resize(placed_ids.size());
+    for(const auto &placed_id : placed_ids) {
+        const size_t word = placed_id.first / 64;
+        const std::uint64_t lower_bits = m_bits[word] & ((1ULL << (placed_id.first % 64)) - 1);
+        const size_t slot_index = m_ranks[word] + count_bits(lower_bits);
+        m_hashes[slot_index] = hashes[placed_id.second];
+        m_ids[slot_index] = placed_id.second;
+    }
+
+    // Store the strings left over, read from tree again.
+    if(!level_ids.empty()) {
+        std::sort(level_ids.begin(), level_ids.end());
+        auto id_it = level_ids.begin();
+        std::uint32_t id = 0;
+        for(string_dict_utils::string_iterator it(tree.root()); it != end && id_it != level_ids.end(); ++it, id++) {
+            if(id == *id_it) {
+                m_fallback_ids.emplace(it->substr(0, it->length() - 1), id);
+                ++id_it;
+            }
+        }
+    }
+
+    m_bytes = string_dict_utils::allocated_bytes(m_bits)
+            + string_dict_utils::allocated_bytes(m_ranks)
+            + string_dict_utils::allocated_bytes(m_level_offsets)
+            + string_dict_utils::allocated_bytes(m_hashes)
+            + string_dict_utils::allocated_bytes(m_ids)
+            + string_dict_utils::allocated_bytes(m_fallback_ids);
+    for(const auto &fallback_id : m_fallback_ids) {
+        m_bytes += string_dict_utils::allocated_bytes(fallback_id.first);
+    }
+}
+
+size_t string_dict_perfect_hash::id(const char *str, size_t length) const
+{
+    const std::uint64_t h = hash_string(str, length);
+    const size_t slot_index = slot_of(h);
+    if(slot_index == npos) {
+        if(m_fallback_ids.empty()) {
+            return npos;
+        }
+        const auto it = m_fallback_ids.find(std::string(str, length));
+        return it != m_fallback_ids.end() ? it->second : npos;
+    }
+
+    return m_hashes[slot_index] == h ? m_ids[slot_index] : npos;
+}
+
+size_t string_dict_perfect_hash::slot_of(std::uint64_t hash) const
+{
+    for(size_t level = 0; level + 1 < m_level_offsets.size(); level++) {
+        const size_t level_offset = m_level_offsets[level];
+        const size_t nb_bits = (m_level_offsets[level + 1] - level_offset) * 64;
+        const size_t bit = level_bit(hash, level, nb_bits);
+        const size_t word = level_offset + bit / 64;
+        const std::uint64_t mask = 1ULL << (bit % 64);
+        if(m_bits[word] & mask) {
+            return m_ranks[word] + count_bits(m_bits[word] & (mask - 1));
+        }
+    }
+    return npos;
+}
+
+// (1) The index takes about (gamma * e^(1/gamma)) bits per string for the
+//     levels (about 3.3 bits with gamma = 2) plus 32 bits for ranks every 64
+//     bits and 96 bits per slot. Lookups never read tree, whose nodes are
+//     scattered in memory: a lookup reads one bit array word and its rank per
+//     level visited, then one hash value and one identifier. Verifying hits
+//     against tree instead of comparing hash values would make them exact
+//     but as slow as a lookup in tree, and storing a copy of the strings
+//     would make the index about as large as the strings themselves. Two
+//     strings share h with a probability of about 2^-64 (never if both have
+//     the same length below 8, h being then a bijection of the characters),
+//     so less than one string in 10^13 is expected to be wrongly accepted
+//     when looking up strings which are not among a million strings.
@@ -0,0 +1,82 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef STRING_DICT_PERFECT_HASH_H
+#define STRING_DICT_PERFECT_HASH_H
+
+#include "dtree.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Minimal perfect hash of the strings in a tree of characters (see
+/// string_dict_utils), answering whether a string is in tree and which
+/// identifier it has with a few memory accesses instead of one child lookup
+/// per character. Strings are given dense identifiers in the order they are
+/// read from tree. The hash function is built level by level as in BBHash and
+/// each hash value leads to a slot holding the 64-bit hash value of the string
+/// and its identifier, the strings themselves not being stored: a string
+/// which is not in tree is taken for the one in its slot only if both have
+/// the same hash value, which happens with a probability of about
+/// number_of_strings / 2^64 per lookup (the hash function is not
+/// cryptographic though, so strings chosen to collide are not covered). See
+/// comments on the algorithm in *.cpp file. The index is a snapshot: it must
+/// be rebuilt when strings are added to tree.
+class string_dict_perfect_hash
+{
+public:
+    static const size_t npos; // identifier of strings not in tree
+
+public:
+    /// gamma (at least 1) is the number of bits per string in the first
+    /// level of the hash function: larger values give faster lookups and
+    /// builds but a larger index.
+    explicit string_dict_perfect_hash(const dtree<char> &tree, double gamma = 2.0);
+
+    /// Returns the identifier of the given string (without the
+    /// tree_end_of_string_marker), or npos if string is not in tree.
+    size_t id(const std::string &str) const { return id(str.data(), str.length()); }
+    size_t id(const char *str, size_t length) const;
+    bool contains(const std::string &str) const { return id(str) != npos; }
+
+    size_t size() const { return m_ids.size() + m_fallback_ids.size(); }
+    /// Returns the estimated number of bytes allocated for the index.
+    size_t bytes() const { return m_bytes; }
+
+private:
+    size_t slot_of(std::uint64_t hash) const;
+
+private:
+    std::vector<std::uint64_t> m_bits;   // bit arrays of all levels, one bit set per slot
+    std::vector<std::uint32_t> m_ranks;  // number of bits set before each word of m_bits
+    std::vector<size_t> m_level_offsets; // offset of each level in m_bits (in words), followed by m_bits size
+    std::vector<std::uint64_t> m_hashes; // hash value of the string of each slot
+    std::vector<std::uint32_t> m_ids;    // identifier of the string of each slot
+    std::unordered_map<std::string, size_t> m_fallback_ids; // strings left over after the last level
+    size_t m_bytes {0};
+};
+
+#endif // STRING_DICT_PERFECT_HASH_H
@@ -0,0 +1,282 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "string_dict_qgram_index.h"
+
+#include <algorithm>
+#include <limits>
+
+// Logic: let w be a string in tree, s the given string, and k the edit
+//        budget. A single edit operation on s destroys at most q of its
+//        q-grams (the ones overlapping the edited character), so if
+//        Lev(w, s) <= k then w and s share at least
+//            t = max(|w|, |s|) - q + 1 - k*q
+//        q-grams (counted with multiplicity). Besides, ||w| - |s|| <= k. So
+//        only the strings whose length lies in [|s| - k, |s| + k] are read
+//        from the length buckets, and among them only those sharing at least
+//        t q-grams with s (counted from the postings of the q-grams of s) are
+//        candidates. Candidates are verified with a Levenshtein distance
+//        computation bounded by the lowest cost found so far, and buckets are
+//        read by increasing length difference with s (a lower bound of the
+//        cost of their strings) so that the bound tightens quickly.
+//
+//        When t <= 0 the count filter prunes nothing and every string of the
+//        bucket is a candidate (see prunes()); the index then still avoids
+//        the strings of other lengths but verifying a candidate costs
+//        O(k * |s|) instead of being shared between strings as in the tree.
+//
+// Complexity: O(|s| + p + c * k * |s|) where
+//                 p = number of postings read (strings containing the
+//                     q-grams of s, within the length range)
+//                 c = number of candidates
+//
+// Side notes: see (1) at the bottom of this file.
+
+namespace {
+
+// Budgets are clamped so that costs never overflow (larger budgets cannot
+// make a difference anyway).
+const unsigned int edit_max_limit {std::numeric_limits<unsigned int>::max() / 2};
+
+// Computes Lev(a, b) if it doesn't exceed bound and returns bound + 1
+// otherwise. Only the cells within bound of the diagonal of the matrix are
+// computed (the others cannot lead to a cost lower or equal to bound), and
+// the computation stops as soon as a whole row exceeds bound. Rows prev_row
+// and curr_row hold b_length+1 cells each.
+unsigned int bounded_levenshtein_distance(const char *a,
+                                          size_t a_length,
+                                          const char *b,
+                                          size_t b_length,
+                                          unsigned int bound,
+                                          unsigned int *prev_row,
+                                          unsigned int *curr_row)
+{
+    const size_t length_diff = a_length > b_length ? a_length - b_length : b_length - a_length;
+    if(length_diff > bound) {
+        return bound + 1;
+    }
+
+    const unsigned int saturated_cost = bound + 1; // any cost exceeding bound
+    for(size_t j = 0; j <= b_length; j++) {
+        prev_row[j] = j <= bound ? j : saturated_cost;
+    }
+
+    for(size_t i = 1; i <= a_length; i++) {
+        const size_t first = i > bound ? i - bound : 1;
+        const size_t last = std::min(b_length, i + bound);
+        curr_row[first-1] = first == 1 && i <= bound ? i : saturated_cost;
+        unsigned int row_min_cost = curr_row[first-1];
+        for(size_t j = first; j <= last; j++) {
+            curr_row[j] = std::min({
+                curr_row[j-1] + 1, // insertion cost
+                prev_row[j] + 1, // deletion cost
+                prev_row[j-1] + (a[i-1] == b[j-1] ? 0 : 1), // substitution cost
+                saturated_cost,
+            });
+            row_min_cost = std::min(row_min_cost, curr_row[j]);
+        }
+        if(last < b_length) {
+            curr_row[last+1] = saturated_cost; // read from the next row only
+        }
+        if(row_min_cost > bound) {
+            return saturated_cost;
+        }
+        std::swap(prev_row, curr_row);
+    }
+    return prev_row[b_length];
+}
+
+} // namespace
+
+string_dict_qgram_index::string_dict_qgram_index(const dtree<char> &tree, unsigned int q)
+    : m_q(std::max(1u, std::min(q, 8u)))
+{
+    std::unordered_map<std::uint64_t, unsigned int> qgram_counts;
+
+    const string_dict_utils::string_iterator end;
+    for(string_dict_utils::string_iterator it(tree.root()); it != end; ++it) {
+        const size_t length = it->length() - 1; // without tree_end_of_string_marker
+        const unsigned int id = m_offsets.size();
+        m_offsets.push_back(m_pool.size());
+        m_pool.append(it->data(), length);
+
+        if(length >= m_buckets.size()) {
+            m_buckets.resize(length + 1);
+        }
+        length_bucket &bucket = m_buckets[length];
+        const unsigned int index = bucket.ids.size();
+        bucket.ids.push_back(id);
+
+        qgram_counts.clear();
+        count_qgrams(it->data(), length, qgram_counts);
+        for(const auto &qgram_count : qgram_counts) {
+            bucket.postings[qgram_count.first].push_back(posting {index, qgram_count.second});
+        }
+    }
+    m_offsets.push_back(m_pool.size());
+
+    m_bytes = string_dict_utils::allocated_bytes(m_pool)
+            + string_dict_utils::allocated_bytes(m_offsets)
+            + string_dict_utils::allocated_bytes(m_buckets);
+    for(const length_bucket &bucket : m_buckets) {
+        m_bytes += string_dict_utils::allocated_bytes(bucket.ids) + string_dict_utils::allocated_bytes(bucket.postings);
+        for(const auto &postings : bucket.postings) {
+            m_bytes += string_dict_utils::allocated_bytes(postings.second);
+        }
+    }
+}
+
+string_dict_utils::match_data string_dict_qgram_index::match_string_levenshtein_distance(const std::string &str,
+                                                                                         unsigned int edit_max) const
+{
+    typedef unsigned int uint;
+
+    const std::string &s = str + string_dict_utils::tree_end_of_string_marker;
+    const size_t s_length = str.length();
+    const uint lev_edit_max = std::min(edit_max, edit_max_limit);
+    uint s_matched_id {0};
+    uint s_matched_cost = lev_edit_max + 1; // no match yet
+
+    std::unordered_map<std::uint64_t, uint> s_qgram_counts;
+    count_qgrams(str.data(), s_length, s_qgram_counts);
+
+    std::vector<uint> shared_counts; // number of q-grams shared with s, per string of bucket
+    std::vector<uint> touched_indexes;
+    std::vector<uint> candidate_indexes;
+    std::vector<uint> lev_rows(2 * (s_length + 1));
+
+    // Read buckets by increasing length difference with s.
+    for(size_t length_diff = 0; length_diff <= lev_edit_max; length_diff++) {
+        const uint bound = std::min(lev_edit_max, s_matched_cost);
+        if(length_diff > bound) {
+            break; // no string of the remaining buckets can be matched with a lower or equal cost
+        }
+        for(int sign = 1; sign >= -1; sign -= 2) {
+            if(sign < 0 && (length_diff == 0 || length_diff > s_length)) {
+                continue;
+            }
+            const size_t length = sign > 0 ? s_length + length_diff : s_length - length_diff;
+            if(length >= m_buckets.size()) {
+                continue;
+            }
+            const length_bucket &bucket = m_buckets[length];
+
+            // Select candidates.
+            candidate_indexes.clear();
+            const long q = m_q;
+            const long threshold = static_cast<long>(std::max(length, s_length)) - q + 1 - q * lev_edit_max;
+            if(threshold <= 0) {
+                for(uint i = 0; i < bucket.ids.size(); i++) {
+                    candidate_indexes.push_back(i);
+                }
+            }
+            else {
+                shared_counts.resize(bucket.ids.size());
+                for(const auto &s_qgram_count : s_qgram_counts) {
+                    const auto it = bucket.postings.find(s_qgram_count.first);
+                    if(it == bucket.postings.end()) {
+                        continue;
+                    }
+                    for(const posting &p : it->second) {
+                        if(shared_counts[p.index] == 0) {
+                            touched_indexes.push_back(p.index);
+                        }
+                        shared_counts[p.index] += std::min(s_qgram_count.second, p.count);
+                    }
+                }
+                for(const uint i : touched_indexes) {
+                    if(shared_counts[i] >= threshold) {
+                        candidate_indexes.push_back(i);
+                    }
+                    shared_counts[i] = 0;
+                }
+                touched_indexes.clear();
+            }
+
+            // Verify candidates.
+            for(const uint i : candidate_indexes) {
+                const uint id = bucket.ids[i];
+                const uint cost = bounded_levenshtein_distance(
+                    m_pool.data() + m_offsets[id], length,
+                    str.data(), s_length,
+                    std::min(lev_edit_max, s_matched_cost),
+                    lev_rows.data(), lev_rows.data() + s_length + 1
+                );
+                if(cost < s_matched_cost || (cost == s_matched_cost && cost <= lev_edit_max && id < s_matched_id)) {
+                    s_matched_id = id;
+                    s_matched_cost = cost;
+                }
+            }
+        }
+    }
+
+    const bool s_matched = s_matched_cost <= lev_edit_max;
+    const std::string &s_matched_string = !s_matched ? "" :
+        m_pool.substr(m_offsets[s_matched_id], m_offsets[s_matched_id+1] - m_offsets[s_matched_id])
+        + string_dict_utils::tree_end_of_string_marker;
+
+    string_dict_utils::match_data match;
+    match.set(
+        "leven-match(" + std::to_string(edit_max) + ")",
+        str,
+        s_matched,
+        [&]() { return "\"" + s + "\" matched successfully with \""
+                     + s_matched_string + "\" using "
+                     + std::to_string(s_matched_cost) + " edits"; },
+        [&]() { return "\"" + s + "\" failed to match"; }
+    );
+    if(match.success) {
+        match.matched = s_matched_string;
+        match.cost = s_matched_cost;
+    }
+    return match;
+}
+
+bool string_dict_qgram_index::prunes(size_t str_length, unsigned int edit_max) const
+{
+    // The threshold t (see logic above) is positive for all lengths in the
+    // range read when it is positive for the length of the given string.
+    return str_length + 1 > static_cast<size_t>(m_q) * (std::min(edit_max, edit_max_limit) + 1);
+}
+
+void string_dict_qgram_index::count_qgrams(const char *str,
+                                           size_t length,
+                                           std::unordered_map<std::uint64_t, unsigned int> &counts) const
+{
+    for(size_t i = 0; i + m_q <= length; i++) {
+        std::uint64_t qgram = 0;
+        for(size_t j = 0; j < m_q; j++) {
+            qgram = (qgram << 8) | static_cast<unsigned char>(str[i+j]);
+        }
+        counts[qgram]++;
+    }
+}
+
+// (1) Only q-grams read inside strings are indexed (strings are not padded
+//     with q-1 extra characters on each side as is sometimes done). Strings
+//     shorter than q therefore have no q-gram, which is fine since t <= 0
+//     whenever they are within the edit budget of the given string. Besides
+//     q must be small enough for t to be positive for the strings usually
+//     matched: q = 2 suits strings of ten characters or more matched with 3
+//     or 4 edits.
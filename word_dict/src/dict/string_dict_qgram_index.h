@@ -0,0 +1,89 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef STRING_DICT_QGRAM_INDEX_H
+#define STRING_DICT_QGRAM_INDEX_H
+
+#include "string_dict_utils.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Inverted index of the q-grams (substrings of q characters) of the strings
+/// in a tree of characters (see string_dict_utils), used to find a string
+/// within a given Levenshtein distance of another one without traversing the
+/// tree. Strings are given dense identifiers in the order they are read from
+/// tree and are bucketed by length; candidates are selected by length and by
+/// number of shared q-grams, then verified one by one. This pays off when the
+/// edit budget is so large that traversing the tree amounts to reading most
+/// of it (see comments on the algorithm in *.cpp file). The index is a
+/// snapshot: it must be rebuilt when strings are added to tree.
+class string_dict_qgram_index
+{
+public:
+    /// q is clamped to [1, 8].
+    explicit string_dict_qgram_index(const dtree<char> &tree, unsigned int q = 2);
+
+    /// Same result as string_dict_utils::match_string_levenshtein_distance(),
+    /// except that the string matched (if any) is the one with the lowest
+    /// cost (the first one in tree in case of tie).
+    string_dict_utils::match_data match_string_levenshtein_distance(const std::string &str,
+                                                                    unsigned int edit_max = 0) const;
+
+    /// Returns whether the number of shared q-grams prunes candidates for
+    /// strings of the given length, i.e. whether matching them with the
+    /// given edit budget reads fewer strings than the whole length buckets.
+    bool prunes(size_t str_length, unsigned int edit_max) const;
+
+    unsigned int q() const { return m_q; }
+    size_t size() const { return m_offsets.size() - 1; }
+    /// Returns the estimated number of bytes allocated for the index.
+    size_t bytes() const { return m_bytes; }
+
+private:
+    typedef struct {
+        unsigned int index; // index of string in length bucket
+        unsigned int count; // number of occurrences of q-gram in string
+    } posting;
+
+    typedef struct {
+        std::vector<unsigned int> ids; // identifiers of strings of this length
+        std::unordered_map<std::uint64_t, std::vector<posting>> postings; // strings of this length per q-gram
+    } length_bucket;
+
+    void count_qgrams(const char *str,
+                      size_t length,
+                      std::unordered_map<std::uint64_t, unsigned int> &counts) const;
+
+private:
+    const unsigned int m_q;
+    std::string m_pool;            // strings read from tree (without tree_end_of_string_marker), concatenated
+    std::vector<size_t> m_offsets; // offset of each string in pool, followed by pool size
+    std::vector<length_bucket> m_buckets; // indexed by string length
+    size_t m_bytes {0};
+};
+
+#endif // STRING_DICT_QGRAM_INDEX_H
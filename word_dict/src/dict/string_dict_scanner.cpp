@@ -0,0 +1,291 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "string_dict_scanner.h"
+
+#include "string_dict_utils.h"
+
+#include <algorithm>
+
+const string_dict_scanner::state_t string_dict_scanner::root_state;
+const string_dict_scanner::state_t string_dict_scanner::no_state;
+const string_dict_scanner::state_t string_dict_scanner::no_word;
+
+namespace {
+
+const unsigned int inactive_cost {UINT_MAX};
+
+// Number of children from which children are searched by dichotomy instead of
+// linearly.
+const unsigned int children_count_for_binary_search {8};
+
+// Maximal number of entries of the full transition table of the automaton
+// (64 MiB), beyond which failure links are followed while scanning instead.
+const size_t transitions_count_max {1 << 24};
+
+} // namespace
+
+string_dict_scanner::string_dict_scanner(const dtree<char> &tree)
+{
+    // Tree nodes are numbered level by level (breadth-first) so the children
+    // of a node have consecutive numbers, and a node always has a greater
+    // number than its parent. For each node we also remember how many of its
+    // children are read from a character less than the
+    // tree_end_of_string_marker, i.e. where the string read to reach the node
+    // comes among the strings of its subtree in the order of tree.
+    std::vector<const dtree<char>::node_t*> nodes {&tree.root()};
+    std::vector<state_t> marker_positions;
+    std::vector<bool> ends_string {false};
+    m_chars.push_back('\0');
+    for(state_t state = 0; state < nodes.size(); state++) {
+        m_first_children.push_back(nodes.size());
+        marker_positions.push_back(no_state);
+        for(auto it = nodes[state]->begin(); it != nodes[state]->end(); it++) {
+            if(it->first == string_dict_utils::tree_end_of_string_marker) {
+                ends_string[state] = true;
+                marker_positions[state] = nodes.size() - m_first_children[state];
+                continue;
+            }
+            nodes.push_back(&it->second);
+            m_chars.push_back(it->first);
+            ends_string.push_back(false);
+        }
+        m_children_counts.push_back(nodes.size() - m_first_children[state]);
+    }
+
+    // Give strings their identifiers and copy them into the pool, reading
+    // them in the order of tree (depth-first, without recursion).
+    m_word_ids.assign(m_chars.size(), no_word);
+    m_word_offsets.assign(1, 0);
+    std::string path;
+    std::vector<std::pair<state_t, state_t>> unvisited_states {{root_state, 0}}; // state and index of next child
+    while(!unvisited_states.empty()) {
+        const state_t state = unvisited_states.back().first;
+        const state_t child_index = unvisited_states.back().second++;
+        if(child_index == marker_positions[state]) {
+            m_word_ids[state] = m_word_offsets.size() - 1;
+            m_word_pool += path;
+            m_word_offsets.push_back(m_word_pool.length());
+            m_word_length_max = std::max<unsigned int>(m_word_length_max, path.length());
+        }
+        if(child_index < m_children_counts[state]) {
+            const state_t child = m_first_children[state] + child_index;
+            path += m_chars[child];
+            unvisited_states.push_back(std::make_pair(child, 0));
+        }
+        else {
+            if(state != root_state) {
+                path.pop_back();
+            }
+            unvisited_states.pop_back();
+        }
+    }
+
+    // Compute failure and output links (Aho-Corasick): the failure state of a
+    // state is the one reached by reading the longest proper suffix (of the
+    // string read to reach the state) which can be read from root. States are
+    // visited level by level so failure states are always known beforehand.
+    // When it is small enough, the full transition table is filled at the
+    // same time: the transitions of a state are those of its failure state,
+    // except for the characters read to reach its children. Characters are
+    // grouped into classes (one per character read in tree, plus one for the
+    // others) to keep the table small.
+    m_char_classes.assign(UCHAR_MAX + 1, 0);
+    for(state_t state = 1; state < m_chars.size(); state++) {
+        unsigned char &char_class = m_char_classes[static_cast<unsigned char>(m_chars[state])];
+        if(char_class == 0) {
+            char_class = m_class_count++;
+        }
+    }
+    if(m_chars.size() * m_class_count <= transitions_count_max) {
+        m_transitions.assign(m_chars.size() * m_class_count, root_state);
+    }
+    m_root_nexts.assign(UCHAR_MAX + 1, root_state);
+    for(state_t i = 0; i < m_children_counts[root_state]; i++) {
+        const state_t child = m_first_children[root_state] + i;
+        m_root_nexts[static_cast<unsigned char>(m_chars[child])] = child;
+    }
+    m_failures.assign(m_chars.size(), root_state);
+    m_outputs.assign(m_chars.size(), no_state);
+    for(state_t state = 0; state < m_chars.size(); state++) {
+        state_t *transitions = m_transitions.empty() ? nullptr : &m_transitions[state * m_class_count];
+        if(transitions && state != root_state) {
+            const state_t *failure_transitions = &m_transitions[m_failures[state] * m_class_count];
+            std::copy(failure_transitions, failure_transitions + m_class_count, transitions);
+        }
+
+        const state_t first_child = m_first_children[state];
+        const state_t last_child = first_child + m_children_counts[state];
+        for(state_t child = first_child; child < last_child; child++) {
+            const state_t failure = state == root_state ? root_state
+                                                        : next_state(m_failures[state], m_chars[child]);
+            m_failures[child] = failure;
+            m_outputs[child] = failure != root_state && ends_string[failure] ? failure : m_outputs[failure];
+            if(transitions) {
+                transitions[m_char_classes[static_cast<unsigned char>(m_chars[child])]] = child;
+            }
+        }
+    }
+
+    m_costs.assign(m_chars.size(), inactive_cost);
+    reset();
+}
+
+void string_dict_scanner::reset(unsigned int edit_max)
+{
+    m_edit_max = std::min(edit_max, m_word_length_max); // the cost of a state never exceeds its depth
+    m_offset = 0;
+    m_state = root_state;
+    m_cost_buckets.resize(m_edit_max + 1);
+
+    // Before any character is read from text, the cost of a state is the
+    // number of characters read to reach it (they all have to be deleted).
+    m_actives.clear();
+    relax_cost(root_state, 0);
+    close_costs();
+    collect_costs();
+}
+
+void string_dict_scanner::update_costs(char c)
+{
+    // Logic: same recurrence as in string_dict_utils::match_string_levenshtein_distance()
+    //        except that the roles of tree and given string are swapped: we
+    //        keep one cost per state (for the string read to reach the state)
+    //        and update all costs each time a character is read from text.
+    //        The cost of root is always 0 so that occurrences can start
+    //        anywhere in text. Only states whose cost doesn't exceed edit_max
+    //        are kept (the active states), and each character c read from
+    //        text updates costs as follows:
+    //            Cost[child] = min(Cost[state] + (c == char_of_child ? 0 : 1)) // substitution
+    //            Cost[state] = min(Cost[state] + 1)                            // insertion
+    //            Cost[child] = min(Cost[state_after_update] + 1)               // deletion
+    //        Strings ending at an updated state whose cost doesn't exceed
+    //        edit_max occur in text (see feed_approximately()).
+    //
+    // Complexity: O(length_of_text * number_of_active_states * n) where n is
+    //             the number of children of the node with the widest
+    //             offspring in tree. The number of active states grows
+    //             quickly with edit_max.
+
+    relax_cost(root_state, 0);
+    for(const auto &active : m_actives) {
+        const state_t state = active.first;
+        const unsigned int cost = active.second;
+        relax_cost(state, cost + 1);
+        const state_t first_child = m_first_children[state];
+        const state_t last_child = first_child + m_children_counts[state];
+        for(state_t child = first_child; child < last_child; child++) {
+            relax_cost(child, cost + (m_chars[child] == c ? 0 : 1));
+        }
+    }
+    close_costs();
+}
+
+string_dict_scanner::state_t string_dict_scanner::child_state(state_t state, char c) const
+{
+    const state_t first_child = m_first_children[state];
+    const state_t last_child = first_child + m_children_counts[state];
+    if(m_children_counts[state] < children_count_for_binary_search) {
+        for(state_t child = first_child; child < last_child; child++) {
+            if(m_chars[child] == c) {
+                return child;
+            }
+        }
+        return no_state;
+    }
+
+    const auto first = m_chars.begin() + first_child;
+    const auto last = m_chars.begin() + last_child;
+    const auto it = std::lower_bound(first, last, c);
+    return it != last && *it == c ? first_child + (it - first) : no_state;
+}
+
+string_dict_scanner::state_t string_dict_scanner::next_state(state_t state, char c) const
+{
+    if(!m_transitions.empty()) {
+        return m_transitions[state * m_class_count + m_char_classes[static_cast<unsigned char>(c)]];
+    }
+    while(state != root_state) {
+        const state_t child = child_state(state, c);
+        if(child != no_state) {
+            return child;
+        }
+        state = m_failures[state];
+    }
+    return m_root_nexts[static_cast<unsigned char>(c)];
+}
+
+void string_dict_scanner::relax_cost(state_t state, unsigned int cost)
+{
+    if(cost > m_edit_max || cost >= m_costs[state]) {
+        return;
+    }
+    if(m_costs[state] == inactive_cost) {
+        m_touched_states.push_back(state);
+    }
+    m_costs[state] = cost;
+}
+
+void string_dict_scanner::close_costs()
+{
+    // Propagates deletion costs to children. Costs range from 0 to edit_max
+    // and each deletion costs 1, so states are visited by increasing cost
+    // from one bucket per cost (a state is then visited once its cost is
+    // final, and states whose cost decreased after being bucketed are
+    // skipped).
+    for(const state_t state : m_touched_states) {
+        m_cost_buckets[m_costs[state]].push_back(state);
+    }
+    for(unsigned int cost = 0; cost < m_edit_max; cost++) {
+        std::vector<state_t> &bucket = m_cost_buckets[cost];
+        for(size_t i = 0; i < bucket.size(); i++) {
+            const state_t state = bucket[i];
+            if(m_costs[state] != cost) {
+                continue;
+            }
+            const state_t first_child = m_first_children[state];
+            const state_t last_child = first_child + m_children_counts[state];
+            for(state_t child = first_child; child < last_child; child++) {
+                if(cost + 1 < m_costs[child]) {
+                    relax_cost(child, cost + 1);
+                    m_cost_buckets[cost + 1].push_back(child);
+                }
+            }
+        }
+        bucket.clear();
+    }
+    m_cost_buckets[m_edit_max].clear();
+}
+
+void string_dict_scanner::collect_costs()
+{
+    // Touched states become the active states, and costs are reset for the
+    // next update.
+    m_actives.clear();
+    for(const state_t state : m_touched_states) {
+        m_actives.push_back(std::make_pair(state, m_costs[state]));
+        m_costs[state] = inactive_cost;
+    }
+    m_touched_states.clear();
+}
@@ -0,0 +1,193 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef STRING_DICT_SCANNER_H
+#define STRING_DICT_SCANNER_H
+
+#include "dtree.hpp"
+
+#include <climits>
+#include <string>
+#include <vector>
+
+/// Finds all occurrences of the strings of a dictionary (implemented as tree
+/// of characters, see string_dict_utils) in a text, either exactly or within a
+/// given Levenshtein distance. The text can be fed in chunks of any size:
+/// occurrences spanning several chunks are found as well. The scanner works on
+/// its own compact copy of the tree, built once, so the tree can be modified
+/// or destroyed afterwards without affecting the scanner.
+class string_dict_scanner
+{
+public:
+    typedef struct {
+        size_t offset;     // offset in text of the character following the occurrence
+        size_t word_id;    // identifier of the string occurring in text (see word())
+        unsigned int cost; // number of edits needed (0 for exact occurrences)
+    } occurrence;
+
+public:
+    explicit string_dict_scanner(const dtree<char> &tree);
+
+    /// Starts scanning a new text, allowing at most edit_max edits per
+    /// occurrence. Budgets above the length of the longest string are clamped
+    /// to it since every string occurs everywhere with such a budget. See
+    /// comments on each algorithm below and in *.cpp file.
+    void reset(unsigned int edit_max = 0);
+
+    /// Scans the next chunk of text, calling callback (a function taking a
+    /// const occurrence &) for each occurrence ending in that chunk.
+    /// Occurrences ending at the same offset are reported in no particular
+    /// order. The empty string is never reported.
+    template<typename Callback>
+    void feed(const char *chunk, size_t chunk_length, Callback &&callback)
+    {
+        if(m_edit_max == 0) {
+            feed_exactly(chunk, chunk_length, callback);
+        }
+        else {
+            feed_approximately(chunk, chunk_length, callback);
+        }
+    }
+    template<typename Callback>
+    void feed(const std::string &chunk, Callback &&callback)
+    {
+        feed(chunk.data(), chunk.length(), callback);
+    }
+
+    /// Strings are given dense identifiers in the order they are read from
+    /// tree (see string_dict_utils::fetch_tree_strings()), and are returned
+    /// without tree_end_of_string_marker.
+    size_t number_of_words() const { return m_word_offsets.size() - 1; }
+    std::string word(size_t word_id) const
+    {
+        return m_word_pool.substr(m_word_offsets[word_id], m_word_offsets[word_id+1] - m_word_offsets[word_id]);
+    }
+    size_t word_length(size_t word_id) const { return m_word_offsets[word_id+1] - m_word_offsets[word_id]; }
+
+    size_t number_of_states() const { return m_chars.size(); }
+    /// Tells whether exact scanning uses a full transition table (see
+    /// comments in *.cpp file).
+    bool has_transition_table() const { return !m_transitions.empty(); }
+
+private:
+    typedef unsigned int state_t;
+
+    template<typename Callback>
+    void feed_exactly(const char *chunk, size_t chunk_length, Callback &callback)
+    {
+        // Logic: Aho-Corasick automaton. For each character read from text,
+        //        we move to the child state for that character if any,
+        //        otherwise we follow failure links until such a child exists
+        //        (or root is reached); when the full transition table is
+        //        available these moves are precomputed and take one lookup.
+        //        Then all strings ending at the current state or at one of
+        //        its output states occur in text.
+        //
+        // Complexity: O(length_of_text + number_of_occurrences), amortized and
+        //             child lookups aside (they are logarithmic in the number
+        //             of children at most) without the transition table.
+
+        for(size_t i = 0; i < chunk_length; i++) {
+            m_state = m_transitions.empty() ? next_state(m_state, chunk[i])
+                                            : m_transitions[m_state * m_class_count + m_char_classes[static_cast<unsigned char>(chunk[i])]];
+            m_offset++;
+
+            state_t state = m_state != root_state && m_word_ids[m_state] != no_word ? m_state : m_outputs[m_state];
+            for(; state != no_state; state = m_outputs[state]) {
+                report(state, 0, callback);
+            }
+        }
+    }
+    template<typename Callback>
+    void feed_approximately(const char *chunk, size_t chunk_length, Callback &callback)
+    {
+        for(size_t i = 0; i < chunk_length; i++) {
+            m_offset++;
+            update_costs(chunk[i]);
+            for(const state_t state : m_touched_states) {
+                if(state != root_state && m_word_ids[state] != no_word) {
+                    report(state, m_costs[state], callback);
+                }
+            }
+            collect_costs();
+        }
+    }
+    template<typename Callback>
+    void report(state_t state, unsigned int cost, Callback &callback)
+    {
+        m_occurrence.offset = m_offset;
+        m_occurrence.word_id = m_word_ids[state];
+        m_occurrence.cost = cost;
+        callback(static_cast<const occurrence &>(m_occurrence));
+    }
+
+    state_t child_state(state_t state, char c) const;
+    state_t next_state(state_t state, char c) const;
+
+    void update_costs(char c);
+    void relax_cost(state_t state, unsigned int cost);
+    void close_costs();
+    void collect_costs();
+
+private:
+    static const state_t root_state {0};
+    static const state_t no_state {UINT_MAX};
+    static const state_t no_word {UINT_MAX};
+
+    // Automaton (one entry per state, i.e. per tree node which is not read
+    // from the tree_end_of_string_marker, states being numbered level by
+    // level so the children of a state have consecutive numbers).
+    std::vector<char> m_chars;              // character read to reach the state
+    std::vector<state_t> m_first_children;  // first child state
+    std::vector<state_t> m_children_counts; // number of child states
+    std::vector<state_t> m_word_ids;        // identifier of the string read when the state is reached, if any
+    std::vector<state_t> m_failures;        // state of the longest proper suffix in tree
+    std::vector<state_t> m_outputs;         // closest failure state ending a string
+    std::vector<state_t> m_root_nexts;      // next state from root for each character
+
+    // Full transition table (empty if too large): the next state of each
+    // state for each class of characters, characters not read in tree
+    // sharing class 0.
+    std::vector<unsigned char> m_char_classes; // class of each character
+    size_t m_class_count {1};
+    std::vector<state_t> m_transitions;
+
+    // Strings read from tree (without tree_end_of_string_marker), concatenated
+    // in the order of their identifiers.
+    std::string m_word_pool;
+    std::vector<size_t> m_word_offsets; // offset of each string in pool, followed by pool size
+    unsigned int m_word_length_max {0};
+
+    // Scanning state.
+    unsigned int m_edit_max {0};
+    size_t m_offset {0};
+    state_t m_state {0};                                      // exact scanning
+    std::vector<std::pair<state_t, unsigned int>> m_actives;  // approximate scanning
+    std::vector<unsigned int> m_costs;
+    std::vector<state_t> m_touched_states;
+    std::vector<std::vector<state_t>> m_cost_buckets;         // states to close per cost (see close_costs())
+    occurrence m_occurrence; // reused for each occurrence reported
+};
+
+#endif // STRING_DICT_SCANNER_H
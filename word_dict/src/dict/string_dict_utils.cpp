@@ -25,25 +25,300 @@
 #include "string_dict_utils.h"
 
 #include "dtree_utils.hpp"
+#include "string_dict_child_order.h"
+#include "string_dict_lev_columns.h"
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
 #include <stack>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define STRING_DICT_UTILS_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define STRING_DICT_UTILS_PREFETCH(addr) ((void) 0)
+#endif
 
 const char string_dict_utils::tree_end_of_string_marker {'$'}; // any character (excluding those used in tree structure) will do just fine
 
-bool string_dict_utils::add_string(dtree<char> &tree, const std::string &str)
+namespace {
+
+// Number of entries ahead in a frontier for which memory is prefetched during
+// level-synchronous traversals.
+const unsigned int level_prefetch_distance {8};
+
+// Rows in the Levenshtein distance matrix of match_string_levenshtein_distance()
+// are only computed within edit_max of the diagonal: the row reached at depth d
+// (number of characters read from tree) is a band holding cells
+// lev_band_first(d, edit_max) to min(d + edit_max, s.length()), and costs
+// exceeding edit_max are saturated to edit_max+1. See (3) at the bottom of this
+// file. Budgets are clamped to lev_edit_max_limit so that saturated costs never
+// overflow (larger budgets cannot make a difference anyway).
+const unsigned int lev_edit_max_limit {std::numeric_limits<unsigned int>::max() / 2};
+
+size_t lev_band_size(const std::string &s, unsigned int edit_max)
+{
+    return std::min(2 * static_cast<size_t>(edit_max) + 1, s.length() + 1);
+}
+
+size_t lev_band_first(size_t depth, unsigned int edit_max)
+{
+    return depth > edit_max ? depth - edit_max : 0;
+}
+
+// Fills the band of the first row (depth 0) in Levenshtein distance matrix.
+void init_lev_band(unsigned int *band, const std::string &s, unsigned int edit_max)
+{
+    const size_t last = std::min(static_cast<size_t>(edit_max), s.length());
+    for(size_t i = 0; i <= last; i++) {
+        band[i] = i;
+    }
+}
+
+// Computes the band of the row following prev_band in Levenshtein distance
+// matrix when character c is read from tree to reach depth, and returns the
+// minimal cost in that band (edit_max+1 if the band is empty).
+unsigned int compute_lev_band(const unsigned int *prev_band,
+                              unsigned int *curr_band,
+                              char c,
+                              const std::string &s,
+                              size_t depth,
+                              unsigned int edit_max)
+{
+    const unsigned int saturated_cost = edit_max + 1;
+    const size_t prev_first = lev_band_first(depth - 1, edit_max);
+    const size_t prev_last = std::min(depth - 1 + edit_max, s.length());
+    const size_t first = lev_band_first(depth, edit_max);
+    const size_t last = std::min(depth + edit_max, s.length());
+
+    unsigned int band_min_cost = saturated_cost;
+    for(size_t i = first; i <= last; i++) {
+        unsigned int cost = saturated_cost;
+        if(i == 0) {
+            cost = std::min(cost, static_cast<unsigned int>(depth));
+        }
+        else {
+            if(i - 1 >= prev_first) { // prev_last >= i-1 always holds
+                cost = std::min(cost, prev_band[i-1 - prev_first] + (c == s[i-1] ? 0 : 1)); // substitution cost
+            }
+            if(i <= prev_last) { // prev_first <= i always holds
+                cost = std::min(cost, prev_band[i - prev_first] + 1); // deletion cost
+            }
+            if(i > first) {
+                cost = std::min(cost, curr_band[i-1 - first] + 1); // insertion cost
+            }
+        }
+        curr_band[i - first] = cost;
+        band_min_cost = std::min(band_min_cost, cost);
+    }
+    return band_min_cost;
+}
+
+// Returns the bottom-right cell of Levenshtein distance matrix from the band
+// of the row at depth (edit_max+1 if the cell lies outside the band).
+unsigned int lev_band_goal_cost(const unsigned int *band,
+                                const std::string &s,
+                                size_t depth,
+                                unsigned int edit_max)
+{
+    const size_t length_diff = depth > s.length() ? depth - s.length() : s.length() - depth;
+    if(length_diff > edit_max) {
+        return edit_max + 1;
+    }
+    return band[s.length() - lev_band_first(depth, edit_max)];
+}
+
+// Calls visit(c, child) for each child of node, in the order children are
+// pushed onto the stack of a depth-first traversal, until visit returns false:
+// the reverse of the visit order, which is the order of tree if order is null
+// (children are then read in place) or the one given by order otherwise (read
+// into children). Either way the first child is visited first, so nodes left
+// out of the layout of order are visited as with a null order.
+template<typename Visit>
+void visit_children_to_push(const string_dict_child_order *order,
+                            const dtree<char>::node_t &node,
+                            char expected_char,
+                            string_dict_child_order::children_t &children,
+                            Visit visit)
+{
+    if(!order) {
+        for(auto it = node.end(); it != node.begin();) {
+            it--;
+            if(!visit(it->first, &it->second)) {
+                return;
+            }
+        }
+        return;
+    }
+    order->fill_children(node, expected_char, children);
+    for(auto it = children.rbegin(); it != children.rend(); it++) {
+        if(!visit(it->first, it->second)) {
+            return;
+        }
+    }
+}
+
+// Rebuilds the string read from tree to reach the node at the given index in
+// the last level of a level-synchronous traversal. See (2) at the bottom of
+// this file.
+std::string read_string_by_level(const std::vector<std::vector<unsigned int>> &level_parents,
+                                 const std::vector<std::string> &level_chars,
+                                 unsigned int index)
+{
+    std::string str(level_chars.size(), '\0');
+    for(size_t level = level_chars.size(); level-- > 0;) {
+        str[level] = level_chars[level][index];
+        index = level_parents[level][index];
+    }
+    return str;
+}
+
+} // namespace
+
+bool string_dict_utils::add_string(dtree<char> &tree,
+                                   const std::string &str,
+                                   size_t *nb_nodes_added)
 {
+    if(nb_nodes_added) {
+        *nb_nodes_added = 0;
+    }
     if(str.find(string_dict_utils::tree_end_of_string_marker) != std::string::npos) {
         return false; // string must not contain tree_end_of_string_marker
     }
 
+    size_t nb_children_added = 0;
     dtree<char>::node_t *node = &tree.root();
     for(const char c : str + string_dict_utils::tree_end_of_string_marker) {
-        node = &node->set_child(c);
+        const size_t nb_children = node->number_of_children();
+        dtree<char>::node_t *child = &node->set_child(c);
+        nb_children_added += node->number_of_children() - nb_children;
+        node = child;
+    }
+    if(nb_nodes_added) {
+        *nb_nodes_added = nb_children_added;
     }
     return true;
 }
 
+size_t string_dict_utils::add_strings(dtree<char> &tree,
+                                      const std::vector<std::string> &strings,
+                                      unsigned int nb_threads,
+                                      unsigned int prefix_length)
+{
+    // Logic: strings read from tree (i.e. including the
+    //        tree_end_of_string_marker) are partitioned by their prefix of
+    //        length prefix_length. The strings of each partition share the
+    //        same subtree (the one reached after reading the prefix), which
+    //        is built independently from other subtrees by one thread. Then
+    //        each subtree is attached to tree by moving its root node. Strings
+    //        not longer than prefix_length are added directly to tree.
+    //
+    // Complexity: O(total_length_of_strings / nb_threads) for building the
+    //             subtrees, plus O(nb_partitions * prefix_length) for
+    //             attaching them.
+
+    typedef std::vector<const std::string*> partition_t;
+
+    prefix_length = std::max(prefix_length, 1u);
+
+    size_t nb_strings_added = 0;
+    std::vector<std::string> partition_prefixes;
+    std::vector<partition_t> partitions;
+    std::unordered_map<std::string, size_t> partition_indexes;
+    for(const std::string &str : strings) {
+        if(str.find(string_dict_utils::tree_end_of_string_marker) != std::string::npos) {
+            continue; // string must not contain tree_end_of_string_marker
+        }
+        nb_strings_added++;
+
+        if(str.length() < prefix_length) { // the string read from tree is not longer than prefix_length
+            string_dict_utils::add_string(tree, str);
+            continue;
+        }
+
+        const std::string &prefix = str.substr(0, prefix_length);
+        const auto inserted = partition_indexes.emplace(prefix, partitions.size());
+        if(inserted.second) {
+            partition_prefixes.push_back(prefix);
+            partitions.emplace_back();
+        }
+        partitions[inserted.first->second].push_back(&str);
+    }
+
+    // Build subtrees. Each thread allocates nodes from its own memory resource
+    // (see dtree_memory_resource::thread_resource()), the same one from one
+    // call to the next.
+    std::vector<dtree<char>::node_t> subtrees(partitions.size());
+    std::atomic<size_t> next_partition_index {0};
+    const auto &build_subtrees = [&](dtree_memory_resource *resource) {
+        const dtree<char>::node_t::allocator_type allocator(resource);
+        for(size_t i = next_partition_index++; i < partitions.size(); i = next_partition_index++) {
+            dtree<char>::node_t subtree(allocator);
+            for(const std::string *str : partitions[i]) {
+                dtree<char>::node_t *node = &subtree;
+                for(size_t j = prefix_length; j < str->length(); j++) {
+                    node = &node->set_child((*str)[j]);
+                }
+                node->set_child(string_dict_utils::tree_end_of_string_marker);
+            }
+            subtrees[i] = std::move(subtree);
+        }
+    };
+
+    if(nb_threads == 0) {
+        nb_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    nb_threads = std::min<size_t>(nb_threads, std::max<size_t>(partitions.size(), 1));
+
+    dtree_memory_resource *tree_resource = tree.root().get_allocator().resource();
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < nb_threads; i++) {
+        threads.emplace_back(build_subtrees, tree_resource ? tree_resource->thread_resource(i - 1) : nullptr);
+    }
+    build_subtrees(tree_resource); // the calling thread takes part as well
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // Attach subtrees.
+    for(size_t i = 0; i < partitions.size(); i++) {
+        const std::string &prefix = partition_prefixes[i];
+        dtree<char>::node_t *node = &tree.root();
+        for(size_t j = 0; j + 1 < prefix_length; j++) {
+            node = &node->set_child(prefix[j]);
+        }
+        if(!node->attach_child(prefix.back(), std::move(subtrees[i]))) {
+            string_dict_utils::merge_tree_nodes(*node->child_ptr(prefix.back()), std::move(subtrees[i]));
+        }
+    }
+
+    return nb_strings_added;
+}
+
+void string_dict_utils::merge_tree_nodes(dtree<char>::node_t &node, dtree<char>::node_t &&other)
+{
+    // Children of the other node are moved to the given node, except those
+    // already present in the given node which are merged in turn.
+
+    std::stack<std::pair<dtree<char>::node_t*, dtree<char>::node_t*>> unmerged_nodes;
+    unmerged_nodes.push(std::make_pair(&node, &other));
+    while(!unmerged_nodes.empty()) {
+        dtree<char>::node_t *dst_node;
+        dtree<char>::node_t *src_node;
+        std::tie(dst_node, src_node) = unmerged_nodes.top();
+        unmerged_nodes.pop();
+
+        for(auto it = src_node->begin(); it != src_node->end(); it++) {
+            if(!dst_node->attach_child(it->first, std::move(it->second))) {
+                unmerged_nodes.push(std::make_pair(dst_node->child_ptr(it->first), &it->second));
+            }
+        }
+    }
+}
+
 string_dict_utils::match_data string_dict_utils::match_string_exactly(const dtree<char> &tree,
                                                                       const std::string &str)
 {
@@ -90,19 +365,29 @@ string_dict_utils::match_data string_dict_utils::match_string_exactly(const dtre
                      + s.at(s_nb_chars_read) + "' after reading \""
                      + s.substr(0, s_nb_chars_read) + "\" successfully"; }
     );
+    if(match.success) {
+        match.matched = s;
+    }
     return match;
 }
 
 string_dict_utils::match_data string_dict_utils::match_string_allow_substitution(const dtree<char> &tree,
                                                                                  const std::string &str,
-                                                                                 unsigned int subst_max)
+                                                                                 unsigned int subst_max,
+                                                                                 traversal strategy,
+                                                                                 const string_dict_child_order *order)
 {
+    if(strategy == traversal::level_synchronous) {
+        return string_dict_utils::match_string_allow_substitution_by_level(tree, str, subst_max);
+    }
+
     // The algorithm below might be recursive but we prefer it iterative.
     //
     // Logic: we compute the number of substitutions for each node in tree and
     //        yield success (when a string matching the given substitution
     //        criteria is read) or failure (in case no string in tree matches
-    //        the given criteria).
+    //        the given criteria). Nodes whose number of substitutions exceeds
+    //        the given limit are not visited.
     //
     // Complexity: O(number_of_nodes_in_tree) or roughly O(n ^ min(l, L)) where
     //                 n = number of children of the node with the widest
@@ -123,6 +408,8 @@ string_dict_utils::match_data string_dict_utils::match_string_allow_substitution
     std::string s_matched_string;
     uint s_matched_string_cost {0};
 
+    string_dict_child_order::children_t children; // children of the node being visited
+
     // Set first tree node to visit.
     std::stack<
             std::tuple<const dtree<char>::node_t*, std::string, uint, uint>
@@ -147,25 +434,25 @@ string_dict_utils::match_data string_dict_utils::match_string_allow_substitution
         const char expected_char = s.at(prev_nb_chars_read);
 
         // Visit picked tree node.
-        for(auto it = prev_node->begin(); it != prev_node->end(); it++) {
-            const std::string &curr_read_string = prev_read_string + it->first;
+        visit_children_to_push(order, *prev_node, expected_char, children, [&](char c, const dtree<char>::node_t *child) {
+            const std::string &curr_read_string = prev_read_string + c;
             const uint curr_nb_chars_read = prev_nb_chars_read + 1;
 
             // Decide whether one must substitute or not.
-            if(expected_char == it->first) {
+            if(expected_char == c) {
                 if(curr_nb_chars_read == s_len) {
                     if(prev_subst_cost <= subst_max) {
                         s_matched = true;
                         s_matched_string = curr_read_string;
                         s_matched_string_cost = prev_subst_cost;
-                        break;
+                        return false;
                     }
                 }
                 else {
                     if(curr_nb_chars_read < s_len) {
                         unvisited_nodes.push(
                             std::make_tuple(
-                                &it->second,
+                                child,
                                 curr_read_string,
                                 curr_nb_chars_read,
                                 prev_subst_cost // 0 substitution needed
@@ -175,10 +462,12 @@ string_dict_utils::match_data string_dict_utils::match_string_allow_substitution
                 }
             }
             else {
-                if(curr_nb_chars_read < s_len) {
+                // Nodes reached with more substitutions than allowed can't
+                // lead to a match, so they are not saved.
+                if(curr_nb_chars_read < s_len && prev_subst_cost < subst_max) {
                     unvisited_nodes.push(
                         std::make_tuple(
-                            &it->second,
+                            child,
                             curr_read_string,
                             curr_nb_chars_read,
                             prev_subst_cost + 1 // 1 substitution needed
@@ -186,7 +475,8 @@ string_dict_utils::match_data string_dict_utils::match_string_allow_substitution
                     );
                 }
             }
-        }
+            return true;
+        });
     }
 
     string_dict_utils::match_data match;
@@ -199,13 +489,23 @@ string_dict_utils::match_data string_dict_utils::match_string_allow_substitution
                       + std::to_string(s_matched_string_cost) + " substs"; },
         [&]() { return "\"" + s + "\" failed to match"; }
     );
+    if(match.success) {
+        match.matched = s_matched_string;
+        match.cost = s_matched_string_cost;
+    }
     return match;
 }
 
 string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distance(const dtree<char> &tree,
                                                                                    const std::string &str,
-                                                                                   unsigned int edit_max)
+                                                                                   unsigned int edit_max,
+                                                                                   traversal strategy,
+                                                                                   const string_dict_child_order *order)
 {
+    if(strategy == traversal::level_synchronous) {
+        return string_dict_utils::match_string_levenshtein_distance_by_level(tree, str, edit_max);
+    }
+
     // The algorithm below might be recursive but we prefer it iterative.
     //
     // Logic: we compute the Levenshtein distance from all strings in tree to
@@ -241,8 +541,12 @@ string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distan
     // to the given string, starting at first character in tree down to leaf
     // nodes.
     //
-    // Complexity: O(length_of_given_string * nb_of_nodes_in_tree) or roughly
-    //             O(length_of_given_string * n ^ min(l, L)) where
+    // Only the cells of a row lying within edit_max of the diagonal are
+    // computed though (the band of the row), because the others always cost
+    // more than edit_max. See (3) at the bottom of this file.
+    //
+    // Complexity: O(min(2 * edit_max + 1, length_of_given_string) * nb_of_nodes_in_tree)
+    //             or roughly O(min(2 * edit_max + 1, l) * n ^ min(l, L)) where
     //                 n = number of children of the node with the widest
     //                     offspring in tree (this value is bounded by 256 for
     //                     char type and n is reduced to log(n) with the dtree
@@ -261,11 +565,11 @@ string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distan
     std::string s_matched_string;
     uint s_matched_string_cost {0};
 
-    uint_vector s_lev_row; // first row in Levenshtein distance matrix
-    const uint s_lev_row_size = s.length() + 1;
-    for(uint i=0; i<s_lev_row_size; i++) {
-        s_lev_row.push_back(i);
-    }
+    const uint lev_edit_max = std::min(edit_max, lev_edit_max_limit);
+    uint_vector s_lev_row(lev_band_size(s, lev_edit_max)); // first row in Levenshtein distance matrix
+    init_lev_band(s_lev_row.data(), s, lev_edit_max);
+
+    string_dict_child_order::children_t children; // children of the node being visited
 
     // Set first tree node to visit.
     std::stack<
@@ -288,27 +592,33 @@ string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distan
 
         const uint prev_lev_row_size = prev_lev_row.size();
 
-        // Visit picked tree node.
-        for(auto it = prev_node->begin(); it != prev_node->end(); it++) {
-            const std::string &curr_read_string = prev_read_string + it->first;
+        // Visit picked tree node (the character expected on the diagonal of
+        // Levenshtein distance matrix is tried first if requested).
+        const char expected_char = prev_read_string.length() < s.length() ? s[prev_read_string.length()]
+                                                                            : string_dict_utils::tree_end_of_string_marker;
+        visit_children_to_push(order, *prev_node, expected_char, children, [&](char c, const dtree<char>::node_t *child) {
+            const std::string &curr_read_string = prev_read_string + c;
 
             // Compute current row in Levenshtein distance matrix.
-            uint_vector curr_lev_row;
-            curr_lev_row.push_back(prev_lev_row.at(0) + 1);
-            for(uint i = 1; i < prev_lev_row_size; i++) {
-                curr_lev_row.push_back(
-                    std::min({
-                        curr_lev_row.at(i-1) + 1, // insertion cost
-                        prev_lev_row.at(i) + 1, // deletion cost
-                        prev_lev_row.at(i-1) + (it->first == s.at(i-1) ? 0 : 1), // substitution cost
-                    })
-                );
-            }
+            uint_vector curr_lev_row(prev_lev_row_size);
+            const uint curr_lev_row_min_cost = compute_lev_band(
+                prev_lev_row.data(),
+                curr_lev_row.data(),
+                c,
+                s,
+                curr_read_string.length(),
+                lev_edit_max
+            );
 
             // Check if we have reached a string matching the given edit distance criteria.
-            const uint curr_lev_row_goal_cost = curr_lev_row.at(curr_lev_row.size()-1);
-            if(curr_lev_row_goal_cost <= edit_max
-            && it->first == string_dict_utils::tree_end_of_string_marker) {
+            const uint curr_lev_row_goal_cost = lev_band_goal_cost(
+                curr_lev_row.data(),
+                s,
+                curr_read_string.length(),
+                lev_edit_max
+            );
+            if(curr_lev_row_goal_cost <= lev_edit_max
+            && c == string_dict_utils::tree_end_of_string_marker) {
                 s_matched = true;
                 s_matched_string = curr_read_string;
                 s_matched_string_cost = curr_lev_row_goal_cost;
@@ -317,14 +627,10 @@ string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distan
             // Save tree node for later visit in case maximal edit cost hasn't
             // been reached yet (indeed next time we will be adding either 0 or
             // 1 to the costs in the computed Levenshtein distance matrix's row).
-            const uint curr_lev_row_min_cost = *std::min_element(
-                curr_lev_row.begin(),
-                curr_lev_row.end()
-            );
-            if(curr_lev_row_min_cost <= edit_max) {
+            if(curr_lev_row_min_cost <= lev_edit_max) {
                 unvisited_nodes.push(
                     std::make_tuple(
-                        &it->second,
+                        child,
                         curr_read_string,
                         curr_lev_row
                     )
@@ -332,10 +638,439 @@ string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distan
             }
 
             // Check early break (no need to continue in case of match).
-            if(s_matched) {
+            return !s_matched;
+        });
+    }
+
+    string_dict_utils::match_data match;
+    match.set(
+        "leven-match(" + std::to_string(edit_max) + ")",
+        str,
+        s_matched,
+        [&]() { return "\"" + s + "\" matched successfully with \""
+                     + s_matched_string + "\" using "
+                     + std::to_string(s_matched_string_cost) + " edits"; },
+        [&]() { return "\"" + s + "\" failed to match"; }
+    );
+    if(match.success) {
+        match.matched = s_matched_string;
+        match.cost = s_matched_string_cost;
+    }
+    return match;
+}
+
+string_dict_utils::match_data string_dict_utils::match_closest_string_levenshtein_distance(const dtree<char> &tree,
+                                                                                          const std::string &str,
+                                                                                          unsigned int edit_max)
+{
+    // Logic: same computation of the Levenshtein distance as in
+    //        match_string_levenshtein_distance() except that the traversal
+    //        doesn't stop at the first string matched. Children are visited
+    //        in the order of tree, so strings are read in the order of tree
+    //        and a string matched only replaces the previous one when it
+    //        costs less. The budget then tightens to that cost minus one, so
+    //        the nodes whose row costs more are not visited, and the
+    //        traversal stops when the given string itself is matched. The
+    //        rows of the nodes on the current path are stored one after the
+    //        other in a single buffer, so no row or string is copied per
+    //        visited node.
+    //
+    // Complexity: O(min(2 * edit_max + 1, l) * nb_of_visited_nodes) where
+    //             the visited nodes are those of match_string_levenshtein_distance()
+    //             when no string is matched, the ones within the tightened
+    //             budget otherwise. See match_string_levenshtein_distance().
+    //
+    // Side notes: the band of rows keeps the width given by edit_max while
+    //             the budget tightens, so that rows needn't be recomputed.
+
+    typedef unsigned int uint;
+    typedef dtree<char>::node_t node_t;
+
+    const std::string &s = str + string_dict_utils::tree_end_of_string_marker;
+    bool s_matched {false};
+    std::string s_matched_string;
+    uint s_matched_string_cost {0};
+
+    const uint lev_edit_max = std::min(edit_max, lev_edit_max_limit);
+    const size_t lev_row_size = lev_band_size(s, lev_edit_max);
+    std::vector<uint> lev_rows(lev_row_size); // row at depth d starts at d * lev_row_size
+    init_lev_band(lev_rows.data(), s, lev_edit_max);
+    uint cost_max = lev_edit_max; // highest cost of a string replacing the one matched
+
+    std::string read_string;
+    std::vector<std::pair<node_t::const_iterator, node_t::const_iterator>> unvisited_children;
+    unvisited_children.push_back(std::make_pair(tree.root().begin(), tree.root().end()));
+    while(!unvisited_children.empty()) {
+        auto &children = unvisited_children.back();
+        if(children.first == children.second) {
+            unvisited_children.pop_back();
+            if(!unvisited_children.empty()) {
+                read_string.pop_back();
+            }
+            continue;
+        }
+        const auto it = children.first++;
+
+        const size_t depth = read_string.length() + 1;
+        if(lev_rows.size() < (depth + 1) * lev_row_size) {
+            lev_rows.resize((depth + 1) * lev_row_size);
+        }
+        uint *curr_lev_row = lev_rows.data() + depth * lev_row_size;
+        const uint curr_lev_row_min_cost = compute_lev_band(
+            curr_lev_row - lev_row_size,
+            curr_lev_row,
+            it->first,
+            s,
+            depth,
+            lev_edit_max
+        );
+
+        if(it->first == string_dict_utils::tree_end_of_string_marker) {
+            const uint curr_lev_row_goal_cost = lev_band_goal_cost(curr_lev_row, s, depth, lev_edit_max);
+            if(curr_lev_row_goal_cost <= cost_max) {
+                s_matched = true;
+                s_matched_string = read_string + it->first;
+                s_matched_string_cost = curr_lev_row_goal_cost;
+                if(curr_lev_row_goal_cost == 0) {
+                    break; // no string costs less
+                }
+                cost_max = curr_lev_row_goal_cost - 1;
+            }
+            continue;
+        }
+
+        // Costs never decrease down the tree (see match_string_levenshtein_distance()).
+        if(curr_lev_row_min_cost <= cost_max) {
+            read_string += it->first;
+            unvisited_children.push_back(std::make_pair(it->second.begin(), it->second.end()));
+        }
+    }
+
+    string_dict_utils::match_data match;
+    match.set(
+        "leven-match(" + std::to_string(edit_max) + ")",
+        str,
+        s_matched,
+        [&]() { return "\"" + s + "\" matched successfully with \""
+                     + s_matched_string + "\" using "
+                     + std::to_string(s_matched_string_cost) + " edits"; },
+        [&]() { return "\"" + s + "\" failed to match"; }
+    );
+    if(match.success) {
+        match.matched = s_matched_string;
+        match.cost = s_matched_string_cost;
+    }
+    return match;
+}
+
+std::vector<string_dict_utils::match_data> string_dict_utils::match_strings_levenshtein_distance(const dtree<char> &tree,
+                                                                                                const std::vector<std::string> &strs,
+                                                                                                unsigned int edit_max)
+{
+    // Logic: strings are sorted so that strings sharing a prefix are adjacent
+    //        (which amounts to visiting the trie of the given strings
+    //        depth-first). Then we compute the Levenshtein distance from all
+    //        strings in tree to each given string column by column (see
+    //        string_dict_lev_columns), the columns computed for the prefix
+    //        shared with the previous string being reused. A string is matched
+    //        when a node read from the tree_end_of_string_marker remains active
+    //        in the last column, the one with the lowest cost being chosen
+    //        (the first one in the order of tree in case of tie).
+    //
+    // Complexity: O(number_of_columns_computed * number_of_active_nodes * n)
+    //             where number_of_columns_computed is the number of nodes in
+    //             the trie of the given strings (at most their total length
+    //             plus one per string for the tree_end_of_string_marker), and
+    //             n is the number of children of the node with the widest
+    //             offspring in tree.
+    //
+    // Side notes: unlike match_string_levenshtein_distance() which stops at
+    //             the first string matched, each column holds all nodes
+    //             within edit_max. So for large edit_max on dense trees,
+    //             matching strings one by one is faster (even when looking
+    //             for the closest string, see word_dict_bench).
+
+    typedef string_dict_lev_columns::entry entry;
+
+    std::vector<size_t> order(strs.size());
+    for(size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&strs](size_t a, size_t b) { return strs[a] < strs[b]; });
+
+    string_dict_lev_columns columns(tree, edit_max);
+    std::vector<string_dict_utils::match_data> matches(strs.size());
+    for(const size_t index : order) {
+        const std::string &str = strs[index];
+        const std::string &s = str + string_dict_utils::tree_end_of_string_marker;
+
+        // Reuse the columns of the prefix shared with the previous string.
+        const std::string &prev_s = columns.str();
+        const auto &mismatch = std::mismatch(s.begin(), s.begin() + std::min(s.length(), prev_s.length()), prev_s.begin());
+        const size_t shared_prefix_length = mismatch.first - s.begin();
+        while(columns.str().length() > shared_prefix_length) {
+            columns.pop();
+        }
+        for(size_t i = shared_prefix_length; i < s.length(); i++) {
+            columns.push(s[i]);
+        }
+
+        // Entries come in no particular order, so ties are broken by
+        // comparing strings (only read from tree for entries of equal cost).
+        const entry *matched_entry = nullptr;
+        std::string matched_string;
+        for(const entry &curr : columns.top()) {
+            if(columns.path_char(curr.path) != string_dict_utils::tree_end_of_string_marker
+            || (matched_entry && curr.cost > matched_entry->cost)) {
+                continue;
+            }
+            std::string curr_string = columns.path_string(curr.path);
+            if(!matched_entry || curr.cost < matched_entry->cost
+            || precedes_in_tree(curr_string, matched_string)) {
+                matched_entry = &curr;
+                matched_string = std::move(curr_string);
+            }
+        }
+
+        string_dict_utils::match_data &match = matches[index];
+        match.set(
+            "leven-match(" + std::to_string(edit_max) + ")",
+            str,
+            matched_entry != nullptr,
+            [&]() { return "\"" + s + "\" matched successfully with \""
+                         + matched_string + "\" using "
+                         + std::to_string(matched_entry->cost) + " edits"; },
+            [&]() { return "\"" + s + "\" failed to match"; }
+        );
+        if(match.success) {
+            match.matched = matched_string;
+            match.cost = matched_entry->cost;
+        }
+    }
+    return matches;
+}
+
+string_dict_utils::match_data string_dict_utils::match_string_allow_substitution_by_level(const dtree<char> &tree,
+                                                                                          const std::string &str,
+                                                                                          unsigned int subst_max)
+{
+    // Same logic as match_string_allow_substitution() except that tree is
+    // visited one level at a time. Nodes whose substitution cost exceeds the
+    // given limit are not kept for the next level.
+    //
+    // Complexity: same as match_string_allow_substitution() in the worst case.
+    //
+    // Side notes: see (2) at the bottom of this file.
+
+    typedef unsigned int uint;
+    typedef std::vector<uint> uint_vector;
+
+    const std::string &s = str + string_dict_utils::tree_end_of_string_marker;
+    const uint s_len = s.length();
+    bool s_matched {false};
+    std::string s_matched_string;
+    uint s_matched_string_cost {0};
+
+    // Frontier of the traversal (as structure of arrays): nodes reached at the
+    // current level and the substitution cost of the string read to reach them.
+    std::vector<const dtree<char>::node_t*> frontier_nodes {&tree.root()};
+    uint_vector frontier_costs {0};
+    std::vector<const dtree<char>::node_t*> next_nodes;
+    uint_vector next_costs;
+
+    // Parent index (in previous level) and character read for each node kept
+    // at each level, used to rebuild the matched string.
+    std::vector<uint_vector> level_parents;
+    std::vector<std::string> level_chars;
+
+    // Start visiting.
+    for(uint level = 0; !s_matched && !frontier_nodes.empty(); level++) {
+        const char expected_char = s.at(level);
+        const bool expects_last_char = level + 1 == s_len;
+
+        level_parents.emplace_back();
+        level_chars.emplace_back();
+        uint_vector &next_parents = level_parents.back();
+        std::string &next_chars = level_chars.back();
+        next_nodes.clear();
+        next_costs.clear();
+
+        // Visit all tree nodes in frontier.
+        const uint frontier_size = frontier_nodes.size();
+        for(uint i = 0; i < frontier_size && !s_matched; i++) {
+            if(i + level_prefetch_distance < frontier_size) {
+                STRING_DICT_UTILS_PREFETCH(frontier_nodes[i + level_prefetch_distance]);
+            }
+
+            const uint prev_subst_cost = frontier_costs[i];
+            for(auto it = frontier_nodes[i]->begin(); it != frontier_nodes[i]->end(); it++) {
+                if(expects_last_char) {
+                    // Only the tree_end_of_string_marker can be read here.
+                    if(expected_char == it->first && prev_subst_cost <= subst_max) {
+                        next_parents.push_back(i);
+                        next_chars.push_back(it->first);
+                        s_matched = true;
+                        s_matched_string = read_string_by_level(level_parents, level_chars, next_chars.size()-1);
+                        s_matched_string_cost = prev_subst_cost;
+                        break;
+                    }
+                    continue;
+                }
+
+                const uint curr_subst_cost = prev_subst_cost + (expected_char == it->first ? 0 : 1);
+                if(curr_subst_cost <= subst_max && it->second.has_children()) {
+                    next_nodes.push_back(&it->second);
+                    next_costs.push_back(curr_subst_cost);
+                    next_parents.push_back(i);
+                    next_chars.push_back(it->first);
+                }
+            }
+        }
+
+        std::swap(frontier_nodes, next_nodes);
+        std::swap(frontier_costs, next_costs);
+    }
+
+    string_dict_utils::match_data match;
+    match.set(
+        "subst-match(" + std::to_string(subst_max) + ")",
+        str,
+        s_matched,
+        [&]() { return "\"" + s + "\" matched successfully with \""
+                      + s_matched_string + "\" using "
+                      + std::to_string(s_matched_string_cost) + " substs"; },
+        [&]() { return "\"" + s + "\" failed to match"; }
+    );
+    if(match.success) {
+        match.matched = s_matched_string;
+        match.cost = s_matched_string_cost;
+    }
+    return match;
+}
+
+string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distance_by_level(const dtree<char> &tree,
+                                                                                            const std::string &str,
+                                                                                            unsigned int edit_max)
+{
+    // Same logic as match_string_levenshtein_distance() except that tree is
+    // visited one level at a time. Each level is processed in three passes:
+    //     1. expansion: all children of the nodes in frontier are gathered.
+    //     2. update: one row (band) in Levenshtein distance matrix is
+    //        computed for each gathered node, all bands being stored in one
+    //        contiguous buffer.
+    //     3. pruning: nodes whose row cannot lead to a match anymore are
+    //        removed from the new frontier by compacting the arrays.
+    //
+    // Complexity: same as match_string_levenshtein_distance() in the worst
+    //             case.
+    //
+    // Side notes: see (2) at the bottom of this file.
+
+    typedef unsigned int uint;
+    typedef std::vector<uint> uint_vector;
+
+    const std::string &s = str + string_dict_utils::tree_end_of_string_marker;
+    bool s_matched {false};
+    std::string s_matched_string;
+    uint s_matched_string_cost {0};
+
+    const uint lev_edit_max = std::min(edit_max, lev_edit_max_limit);
+    const uint s_lev_row_size = lev_band_size(s, lev_edit_max);
+
+    // Frontier of the traversal (as structure of arrays): nodes reached at the
+    // current level and the band of their row in Levenshtein distance matrix
+    // (the band for node i starts at index i * s_lev_row_size).
+    std::vector<const dtree<char>::node_t*> frontier_nodes {&tree.root()};
+    uint_vector frontier_lev_rows(s_lev_row_size);
+    init_lev_band(frontier_lev_rows.data(), s, lev_edit_max); // first row in Levenshtein distance matrix
+    std::vector<const dtree<char>::node_t*> next_nodes;
+    uint_vector next_lev_rows;
+    uint_vector next_lev_row_min_costs;
+
+    // Parent index (in previous level) and character read for each node kept
+    // at each level, used to rebuild the matched string.
+    std::vector<uint_vector> level_parents;
+    std::vector<std::string> level_chars;
+
+    // Start visiting.
+    while(!s_matched && !frontier_nodes.empty()) {
+        level_parents.emplace_back();
+        level_chars.emplace_back();
+        uint_vector &next_parents = level_parents.back();
+        std::string &next_chars = level_chars.back();
+        next_nodes.clear();
+
+        // 1. Expansion.
+        const uint frontier_size = frontier_nodes.size();
+        for(uint i = 0; i < frontier_size; i++) {
+            if(i + level_prefetch_distance < frontier_size) {
+                STRING_DICT_UTILS_PREFETCH(frontier_nodes[i + level_prefetch_distance]);
+            }
+            for(auto it = frontier_nodes[i]->begin(); it != frontier_nodes[i]->end(); it++) {
+                next_nodes.push_back(&it->second);
+                next_parents.push_back(i);
+                next_chars.push_back(it->first);
+            }
+        }
+
+        // 2. Update.
+        const size_t depth = level_chars.size();
+        const uint next_size = next_nodes.size();
+        next_lev_rows.resize(next_size * s_lev_row_size);
+        next_lev_row_min_costs.resize(next_size);
+        for(uint j = 0; j < next_size; j++) {
+            if(j + level_prefetch_distance < next_size) {
+                STRING_DICT_UTILS_PREFETCH(&frontier_lev_rows[next_parents[j + level_prefetch_distance] * s_lev_row_size]);
+            }
+
+            uint *curr_lev_row = &next_lev_rows[j * s_lev_row_size];
+            next_lev_row_min_costs[j] = compute_lev_band(
+                &frontier_lev_rows[next_parents[j] * s_lev_row_size],
+                curr_lev_row,
+                next_chars[j],
+                s,
+                depth,
+                lev_edit_max
+            );
+
+            // Check if we have reached a string matching the given edit distance criteria.
+            const uint curr_lev_row_goal_cost = lev_band_goal_cost(curr_lev_row, s, depth, lev_edit_max);
+            if(curr_lev_row_goal_cost <= lev_edit_max
+            && next_chars[j] == string_dict_utils::tree_end_of_string_marker) {
+                s_matched = true;
+                s_matched_string = read_string_by_level(level_parents, level_chars, j);
+                s_matched_string_cost = curr_lev_row_goal_cost;
                 break;
             }
         }
+        if(s_matched) {
+            break;
+        }
+
+        // 3. Pruning. Nodes read from tree_end_of_string_marker are leaves so
+        //    they are removed as well.
+        uint kept = 0;
+        for(uint j = 0; j < next_size; j++) {
+            if(next_lev_row_min_costs[j] <= lev_edit_max
+            && next_chars[j] != string_dict_utils::tree_end_of_string_marker) {
+                if(kept != j) {
+                    next_nodes[kept] = next_nodes[j];
+                    next_parents[kept] = next_parents[j];
+                    next_chars[kept] = next_chars[j];
+                    std::copy(next_lev_rows.begin() + j * s_lev_row_size,
+                              next_lev_rows.begin() + (j+1) * s_lev_row_size,
+                              next_lev_rows.begin() + kept * s_lev_row_size);
+                }
+                kept++;
+            }
+        }
+        next_nodes.resize(kept);
+        next_parents.resize(kept);
+        next_chars.resize(kept);
+        next_lev_rows.resize(kept * s_lev_row_size);
+
+        std::swap(frontier_nodes, next_nodes);
+        std::swap(frontier_lev_rows, next_lev_rows);
     }
 
     string_dict_utils::match_data match;
@@ -348,16 +1083,115 @@ string_dict_utils::match_data string_dict_utils::match_string_levenshtein_distan
                      + std::to_string(s_matched_string_cost) + " edits"; },
         [&]() { return "\"" + s + "\" failed to match"; }
     );
+    if(match.success) {
+        match.matched = s_matched_string;
+        match.cost = s_matched_string_cost;
+    }
     return match;
 }
 
+string_dict_utils::string_iterator::string_iterator(const dtree<char>::node_t &node,
+                                                    const std::string &prefix)
+    : string_iterator(node.begin(), node.end(), prefix)
+{
+}
+
+string_dict_utils::string_iterator::string_iterator(dtree<char>::node_t::const_iterator first,
+                                                    dtree<char>::node_t::const_iterator last,
+                                                    const std::string &prefix)
+    : m_string(prefix)
+{
+    m_stack.push_back({first, last});
+    descend();
+}
+
+string_dict_utils::string_iterator::string_iterator(const dtree<char>::node_t &node,
+                                                    const std::string &prefix,
+                                                    const std::string &after)
+    : m_string(prefix)
+{
+    // Logic: we read the given string from tree as far as possible, saving
+    //        the visited children on the stack, then we move to the first
+    //        child following the last character read (or to the child read
+    //        itself in case strings greater than the given one can be read
+    //        from it).
+
+    std::string s = after;
+    if(s.empty() || s.back() != string_dict_utils::tree_end_of_string_marker) {
+        s += string_dict_utils::tree_end_of_string_marker;
+    }
+
+    const dtree<char>::node_t *curr_node = &node;
+    for(size_t i = 0; i < s.length(); i++) {
+        auto it = curr_node->lower_bound(s[i]);
+        if(it != curr_node->end() && it->first == s[i]) {
+            if(it->second.has_children() && i + 1 < s.length()) {
+                m_stack.push_back({it, curr_node->end()});
+                m_string += it->first;
+                curr_node = &it->second;
+                continue;
+            }
+            if(!it->second.has_children()) {
+                it++; // the given string (or one of its prefixes) is skipped
+            }
+        }
+        m_stack.push_back({it, curr_node->end()});
+        break;
+    }
+    descend();
+}
+
+bool string_dict_utils::string_iterator::operator==(const string_iterator &other) const
+{
+    if(m_stack.empty() || other.m_stack.empty()) {
+        return m_stack.empty() && other.m_stack.empty();
+    }
+    return m_stack.size() == other.m_stack.size()
+        && m_stack.back().it == other.m_stack.back().it;
+}
+
+void string_dict_utils::string_iterator::advance()
+{
+    m_string.pop_back();
+    m_stack.back().it++;
+    descend();
+}
+
+void string_dict_utils::string_iterator::descend()
+{
+    // Logic: the characters read to reach the child being visited at the top
+    //        of the stack are in m_string, except the one of that child. We
+    //        go down tree until a leaf node is reached (so a string is read),
+    //        going back up each time all children of a node are visited.
+
+    while(!m_stack.empty()) {
+        frame &top = m_stack.back();
+        if(top.it == top.last) {
+            m_stack.pop_back();
+            if(!m_stack.empty()) {
+                m_string.pop_back();
+                m_stack.back().it++;
+            }
+            continue;
+        }
+
+        m_string += top.it->first;
+        const dtree<char>::node_t &child = top.it->second;
+        if(!child.has_children()) {
+            return;
+        }
+        m_stack.push_back({child.begin(), child.end()});
+    }
+}
+
 void string_dict_utils::fetch_tree_strings(const dtree<char> &tree,
                                            std::vector<std::string> &strings)
 {
     strings.clear();
-    string_dict_utils::fetch_tree_strings(tree, [&strings](const std::string &str) {
-        strings.push_back(str);
-    });
+    const string_iterator end;
+    for(string_iterator it(tree.root()); it != end; ++it) {
+        strings.push_back(*it);
+    }
 }
 
 void string_dict_utils::fetch_tree_strings(const dtree<char> &tree,
@@ -370,18 +1204,82 @@ void string_dict_utils::fetch_tree_strings(const dtree<char> &tree,
 void string_dict_utils::fetch_tree_strings(const dtree<char>::node_t &node,
                                            std::string &acc,
                                            const std::function<void (const std::string &)> &callback) {
-    // The algorithm below is recursive but we don't care because this function
-    // is provided for debugging purpose only (print tree content for instance).
+    // The algorithm below is iterative (see string_iterator) so it is not
+    // limited by the size of the call stack.
 
-    for(auto it = node.begin(); it != node.end(); it++) {
-        acc += it->first;
-        if(it->second.has_children()) {
-            string_dict_utils::fetch_tree_strings(it->second, acc, callback);
-        }
-        else {
-            callback(acc);
+    const string_iterator end;
+    for(string_iterator it(node, acc); it != end; ++it) {
+        callback(*it);
+    }
+}
+
+void string_dict_utils::fetch_tree_strings(const dtree<char> &tree,
+                                           std::vector<std::string> &strings,
+                                           const std::string &after,
+                                           size_t max_count)
+{
+    strings.clear();
+    const string_iterator end;
+    for(string_iterator it(tree.root(), "", after); it != end && strings.size() < max_count; ++it) {
+        strings.push_back(*it);
+    }
+}
+
+void string_dict_utils::fetch_tree_strings_parallel(const dtree<char> &tree,
+                                                    unsigned int nb_threads,
+                                                    const std::function<void (size_t, const std::string &)> &callback)
+{
+    // Logic: each thread repeatedly picks the next unvisited child of the root
+    //        node and iterates over the strings read from it. Picking children
+    //        one at a time (instead of splitting them into groups beforehand)
+    //        balances the load when subtrees have very different sizes.
+
+    const dtree<char>::node_t &root = tree.root();
+    std::vector<dtree<char>::node_t::const_iterator> root_children;
+    for(auto it = root.begin(); it != root.end(); it++) {
+        root_children.push_back(it);
+    }
+
+    std::atomic<size_t> next_child_index {0};
+    const auto &visit_children = [&]() {
+        const string_iterator end;
+        for(size_t i = next_child_index++; i < root_children.size(); i = next_child_index++) {
+            const auto first = root_children[i];
+            for(string_iterator it(first, std::next(first)); it != end; ++it) {
+                callback(i, *it);
+            }
         }
-        acc.pop_back();
+    };
+
+    if(nb_threads == 0) {
+        nb_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    nb_threads = std::min<size_t>(nb_threads, std::max<size_t>(root_children.size(), 1));
+
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < nb_threads; i++) {
+        threads.emplace_back(visit_children);
+    }
+    visit_children(); // the calling thread takes part as well
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+void string_dict_utils::fetch_tree_strings_parallel(const dtree<char> &tree,
+                                                    unsigned int nb_threads,
+                                                    std::vector<std::string> &strings)
+{
+    // Strings are first gathered per child of the root node (each child is
+    // visited by one thread only so no lock is needed) then concatenated.
+    std::vector<std::vector<std::string>> strings_per_child(tree.root().number_of_children());
+    string_dict_utils::fetch_tree_strings_parallel(tree, nb_threads, [&strings_per_child](size_t index, const std::string &str) {
+        strings_per_child[index].push_back(str);
+    });
+
+    strings.clear();
+    for(std::vector<std::string> &child_strings : strings_per_child) {
+        std::move(child_strings.begin(), child_strings.end(), std::back_inserter(strings));
     }
 }
 
@@ -400,9 +1298,58 @@ void string_dict_utils::print_tree_strings(const dtree<char> &tree,
     });
 }
 
+bool string_dict_utils::precedes_in_tree(const std::string &a,
+                                         const std::string &b)
+{
+    // Characters are compared as in tree (i.e. as char, which may be signed).
+    const size_t length = std::min(a.length(), b.length());
+    for(size_t i = 0; i < length; i++) {
+        if(a[i] != b[i]) {
+            return a[i] < b[i];
+        }
+    }
+    if(a.length() == b.length()) {
+        return false;
+    }
+    return a.length() < b.length() ? string_dict_utils::tree_end_of_string_marker < b[length]
+                                   : a[length] < string_dict_utils::tree_end_of_string_marker;
+}
+
 // (1) When we think of it again it is unsure which version of this algorithm is
 //     the fastest. Indeed in the recursive version the call stack will never
 //     contain more than x elements (when x refers to the length of the longest
 //     string in tree). But the iterative version might end up storing all nodes
 //     in tree into a stack. So both versions might be tested and compared in
-//     the future (assuming a recursive version is also provided).
+//     the future (assuming a recursive version is also provided). A level-
+//     synchronous version is provided as well, see (2) below, and the
+//     word_dict_bench program compares it with the iterative version.
+//
+// (2) The level-synchronous version of an algorithm visits tree one level at a
+//     time: all nodes at depth d (the frontier) are visited before any node at
+//     depth d+1. The state attached to nodes in frontier is stored as structure
+//     of arrays (one array for nodes, one for costs or rows in Levenshtein
+//     distance matrix, etc.) instead of one tuple per node on a stack. So a
+//     frontier is updated in batch by walking contiguous memory, which can be
+//     prefetched ahead of use, and no string is copied per visited node (the
+//     matched string is rebuilt from parent indices saved for each level).
+//     Also the first string matched is one of the shortest strings matching
+//     the given criteria, which might not be the string matched by the
+//     iterative version. The tradeoff is that a whole frontier is kept in
+//     memory, which for the Levenshtein distance means one row (band) per
+//     node.
+//
+// (3) The Levenshtein distance matrix between strings a and b (a being read
+//     from tree) is such that Cell[i][j] >= |i - j|, since at least |i - j|
+//     insertions or deletions are needed to match a[0..i) with b[0..j). So
+//     with a budget of k edits only the 2k+1 cells of a row lying within k of
+//     the diagonal can lead to a match (Ukkonen's cutoff), and they only
+//     depend on cells of the previous row lying within k of the diagonal as
+//     well. Rows are therefore stored as bands of at most 2k+1 cells (the
+//     band of the row at depth d starts at cell max(0, d-k)) and cells
+//     outside a band are considered to cost k+1. A cost computed within a
+//     band is exact as long as it doesn't exceed k (costs along the path
+//     leading to a cell never decrease) and is saturated to k+1 otherwise,
+//     which is all pruning needs. Also the bottom-right cell only lies within
+//     the band when |d - length_of_b| <= k. So visiting a node costs O(k)
+//     instead of O(length_of_b), which matters for long strings matched with
+//     small budgets.
@@ -27,9 +27,15 @@
 
 #include "dtree.hpp"
 
+#include <cstddef>
 #include <functional>
+#include <iterator>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+class string_dict_child_order;
+
 /// Utility class for dictionary of strings implemented as tree of characters
 /// (more precisely dtree<char>).
 class string_dict_utils
@@ -40,6 +46,8 @@ public:
         std::string source;    // string to match in tree
         bool success {false};  // has string been matched?
         std::string message;   // message regarding success or failure
+        std::string matched;   // string matched in tree (on success only)
+        unsigned int cost {0}; // number of operations needed to match string (on success only)
 
         // a convenient initialization function to avoid duplicates in code
         void set(const std::string &algorithm,
@@ -70,12 +78,93 @@ public:
         std::string full_str() const { return short_str() + ": " + message; }
     } match_data;
 
+    /// Tree traversal strategies available to the fuzzy string-matching-
+    /// algorithms. See comments on each strategy in *.cpp file.
+    enum class traversal {
+        depth_first,       // iterative, one node at a time from a stack
+        level_synchronous, // iterative, one tree level (frontier) at a time
+    };
+
+    /// Input iterator over the strings in tree, in the order used by
+    /// fetch_tree_strings() (strings include the tree_end_of_string_marker).
+    /// Tree is traversed without recursion using a stack which never holds
+    /// more elements than the height of tree, and the current string is a
+    /// buffer reused from one string to the next (so it is only valid until
+    /// the iterator is incremented). Only the prefix increment is provided
+    /// since a copy of the iterator is a copy of its stack and buffer. Tree
+    /// must not be modified while being iterated over.
+    class string_iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef std::string value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string* pointer;
+        typedef const std::string& reference;
+
+    public:
+        /// Constructs the end iterator.
+        string_iterator() {}
+        /// Constructs an iterator over the strings read from the given node,
+        /// each one being preceded by the given prefix.
+        explicit string_iterator(const dtree<char>::node_t &node,
+                                 const std::string &prefix = "");
+        /// Same as above but only the strings read from the given range of
+        /// children of the node are iterated over.
+        explicit string_iterator(dtree<char>::node_t::const_iterator first,
+                                 dtree<char>::node_t::const_iterator last,
+                                 const std::string &prefix = "");
+        /// Same as the first constructor but the iterator starts at the first
+        /// string following the given one (which need not be in tree). The
+        /// tree_end_of_string_marker is appended to the given string if it is
+        /// missing, so any word or string previously iterated over can be
+        /// used as a cursor.
+        explicit string_iterator(const dtree<char>::node_t &node,
+                                 const std::string &prefix,
+                                 const std::string &after);
+
+        reference operator*() const { return m_string; }
+        pointer operator->() const { return &m_string; }
+
+        string_iterator& operator++() { advance(); return *this; }
+
+        bool operator==(const string_iterator &other) const;
+        bool operator!=(const string_iterator &other) const { return !(*this == other); }
+
+    private:
+        typedef struct {
+            dtree<char>::node_t::const_iterator it;   // child being visited
+            dtree<char>::node_t::const_iterator last; // end of children to visit
+        } frame;
+
+        void advance();
+        void descend();
+
+    private:
+        std::vector<frame> m_stack;
+        std::string m_string;
+    };
+
 public:
     string_dict_utils() = delete;
 
     /// Adds string to tree. Note that string won't be added in case it contains
-    /// the string_dict::tree_end_of_string_marker character.
-    static bool add_string(dtree<char> &tree, const std::string &str);
+    /// the string_dict::tree_end_of_string_marker character. The number of
+    /// nodes inserted in tree (0 if string was already there) is stored in
+    /// nb_nodes_added if not null.
+    static bool add_string(dtree<char> &tree,
+                           const std::string &str,
+                           size_t *nb_nodes_added = nullptr);
+    /// Adds strings to tree and returns the number of strings added (see
+    /// add_string()). Strings are partitioned by their first prefix_length
+    /// characters and the subtree of each partition is built by one of
+    /// nb_threads threads (0 stands for the number of hardware threads)
+    /// before being attached to tree. The resulting tree is the same as the
+    /// one obtained by adding strings one by one.
+    static size_t add_strings(dtree<char> &tree,
+                              const std::vector<std::string> &strings,
+                              unsigned int nb_threads = 0,
+                              unsigned int prefix_length = 1);
 
     /// Least permissive string-matching-algorithm. Fastest. See comments on
     /// complexity in *.cpp file.
@@ -84,16 +173,40 @@ public:
     /// Less permissive than the string-matching-algorithm using the Levenshtein
     /// distance. Faster than the said algorithm limited to substitutions only
     /// (i.e. no insertion or deletion). See comments on complexity in *.cpp
-    /// file.
+    /// file. The children of nodes are visited in the given order if not
+    /// null (depth-first traversal only, see string_dict_child_order).
     static match_data match_string_allow_substitution(const dtree<char> &tree,
                                                       const std::string &str,
-                                                      unsigned int subst_max = 0);
+                                                      unsigned int subst_max = 0,
+                                                      traversal strategy = traversal::depth_first,
+                                                      const string_dict_child_order *order = nullptr);
     /// Most permissive string-matching-algorithm. Slowest. See comments on
     /// complexity in *.cpp file. Note that this function allows substitution,
-    /// insertion and deletion of characters.
+    /// insertion and deletion of characters. The children of nodes are visited
+    /// in the given order as above.
     static match_data match_string_levenshtein_distance(const dtree<char> &tree,
                                                         const std::string &str,
-                                                        unsigned int edit_max = 0);
+                                                        unsigned int edit_max = 0,
+                                                        traversal strategy = traversal::depth_first,
+                                                        const string_dict_child_order *order = nullptr);
+    /// Same as above except that the string matched (if any) is the closest
+    /// one: the one with the lowest distance, the first one in the order of
+    /// tree (see precedes_in_tree()) in case of tie. Tree is traversed depth-
+    /// first in its own order, the budget tightening as strings are matched.
+    /// See comments on complexity in *.cpp file.
+    static match_data match_closest_string_levenshtein_distance(const dtree<char> &tree,
+                                                                const std::string &str,
+                                                                unsigned int edit_max = 0);
+    /// Matches many strings at once (results are returned in the same order
+    /// as strings). Unlike above, the string matched (if any) is the closest
+    /// one: the one with the lowest distance, the first one in the order of
+    /// tree (see precedes_in_tree()) in case of tie. The work done for the
+    /// prefixes shared by strings is shared too, but every string within
+    /// edit_max is considered, so this isn't faster than the function above
+    /// for large edit_max. See comments on complexity in *.cpp file.
+    static std::vector<match_data> match_strings_levenshtein_distance(const dtree<char> &tree,
+                                                                      const std::vector<std::string> &strs,
+                                                                      unsigned int edit_max = 0);
 
     static void fetch_tree_strings(const dtree<char> &tree,
                                    std::vector<std::string> &strings);
@@ -102,10 +215,65 @@ public:
     static void fetch_tree_strings(const dtree<char>::node_t &node,
                                    std::string &acc,
                                    const std::function<void (const std::string &)> &callback);
+    /// Fetches at most max_count strings following the given one (see the
+    /// string_iterator constructors), for cursor-based pagination.
+    static void fetch_tree_strings(const dtree<char> &tree,
+                                   std::vector<std::string> &strings,
+                                   const std::string &after,
+                                   size_t max_count);
+    /// Same as fetch_tree_strings() but the subtrees of the root node are
+    /// shared between nb_threads threads (0 stands for the number of hardware
+    /// threads). The callback is called concurrently with the index of the
+    /// root node's child from which the string is read: strings with the same
+    /// index are fetched in order by the same thread.
+    static void fetch_tree_strings_parallel(const dtree<char> &tree,
+                                            unsigned int nb_threads,
+                                            const std::function<void (size_t, const std::string &)> &callback);
+    static void fetch_tree_strings_parallel(const dtree<char> &tree,
+                                            unsigned int nb_threads,
+                                            std::vector<std::string> &strings);
 
     static void print_tree_structure(const dtree<char> &tree, std::ostream &stream);
     static void print_tree_strings(const dtree<char> &tree, std::ostream &stream);
 
+    /// Tells whether string a comes before string b in the order of tree, i.e.
+    /// the order of fetch_tree_strings(). Strings are compared as if each one
+    /// ended with the tree_end_of_string_marker, so they can be given with or
+    /// without it.
+    static bool precedes_in_tree(const std::string &a, const std::string &b);
+
+    /// Estimated number of bytes allocated by the given containers to hold
+    /// their elements (not counting memory allocated by the elements
+    /// themselves), for the memory accounting of the side structures built
+    /// from tree. Nodes of hash maps are assumed to hold a pointer and the
+    /// hash value of their key along with their element, and a single bucket
+    /// to be held in place, as in the usual implementations.
+    template<typename T>
+    static size_t allocated_bytes(const std::vector<T> &v) { return v.capacity() * sizeof(T); }
+    static size_t allocated_bytes(const std::string &str)
+    {
+        const char *object = reinterpret_cast<const char*>(&str);
+        const bool in_place = !std::less<const char*>()(str.data(), object)
+                           && std::less<const char*>()(str.data(), object + sizeof(str)); // short string optimization
+        return in_place ? 0 : str.capacity() + 1;
+    }
+    template<typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+    static size_t allocated_bytes(const std::unordered_map<Key, T, Hash, KeyEqual, Allocator> &map)
+    {
+        return (map.bucket_count() > 1 ? map.bucket_count() * sizeof(void*) : 0)
+             + map.size() * (sizeof(std::pair<const Key, T>) + sizeof(void*) + sizeof(size_t));
+    }
+
+private:
+    static void merge_tree_nodes(dtree<char>::node_t &node, dtree<char>::node_t &&other);
+
+    static match_data match_string_allow_substitution_by_level(const dtree<char> &tree,
+                                                               const std::string &str,
+                                                               unsigned int subst_max);
+    static match_data match_string_levenshtein_distance_by_level(const dtree<char> &tree,
+                                                                 const std::string &str,
+                                                                 unsigned int edit_max);
+
 public:
     static const char tree_end_of_string_marker;
 };
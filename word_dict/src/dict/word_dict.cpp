@@ -24,34 +24,299 @@
 
 #include "word_dict.h"
 
+#include "dtree_resources.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Smallest edit budget for which the q-gram index is used (see
+// match_closest_word_levenshtein_distance()).
+const unsigned int qgram_index_edit_min {3};
+
+// Estimated number of bytes reserved by the global operator new for an
+// allocation of the given size: usual malloc implementations prepend a size
+// header and round chunks up to 16 bytes.
+size_t heap_allocation_bytes(size_t bytes)
+{
+    return std::max<size_t>(32, (bytes + sizeof(size_t) + 15) / 16 * 16);
+}
+
+// Weight of the hits merged by a relayout() in the next relayout() (see
+// word_dict::relayout()).
+const double hit_count_decay {0.5};
+
+// Hit counters of the dictionary for which a thread last recorded hits (see
+// word_dict::record_hit()).
+typedef struct {
+    std::uint64_t serial;
+    std::vector<std::atomic<std::uint32_t>> *counts;
+} cached_hit_counters;
+
+// Returns a new serial number for the hit counters of a dictionary. Serial
+// numbers are never reused, so cached counters are never mistaken for the
+// counters of another dictionary or for counters dropped since.
+std::uint64_t new_hit_counters_serial()
+{
+    static std::atomic<std::uint64_t> next_serial {1};
+    return next_serial++;
+}
+
+dtree_memory_resource* new_memory_resource(word_dict::memory_policy policy)
+{
+    switch(policy) {
+    case word_dict::memory_policy::arena: return new dtree_monotonic_arena();
+    case word_dict::memory_policy::pool: return new dtree_pool_resource(1 << 16, dtree_utils::node_allocation_bytes<char, dtree<char>::node_t::allocator_type>());
+    case word_dict::memory_policy::heap: break;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+const size_t word_dict::npos {string_dict_perfect_hash::npos};
+
+word_dict::word_dict(memory_policy policy)
+    : m_policy(policy)
+    , m_resource(new_memory_resource(policy))
+    , m_words(dtree<char>::node_t::allocator_type(m_resource.get()))
+    , m_child_order(std::make_shared<string_dict_child_order>())
+    , m_hit_counters_serial(new_hit_counters_serial())
+{
+}
+
+word_dict::word_dict(const word_dict &other)
+    : m_policy(other.m_policy)
+    , m_resource(new_memory_resource(other.m_policy))
+    , m_words(other.m_words, dtree<char>::node_t::allocator_type(m_resource.get()))
+    , m_child_order(std::make_shared<string_dict_child_order>())
+    , m_hit_counters_serial(new_hit_counters_serial())
+{
+    copy_from(other);
+}
+
+word_dict& word_dict::operator=(const word_dict &other)
+{
+    if(this != &other) {
+        m_words = other.m_words; // nodes are allocated with the memory resource of this dictionary
+        copy_from(other);
+    }
+    return *this;
+}
+
+void word_dict::copy_from(const word_dict &other)
+{
+    // The side structures refer to the nodes of the tree, so they are rebuilt
+    // rather than copied. Words keep their identifiers, and so do hits.
+    m_node_count = other.m_node_count;
+    m_word_count = other.m_word_count;
+    reset_layout();
+    m_qgram_index.reset();
+    if(other.m_qgram_index) {
+        build_qgram_index(other.m_qgram_index->q());
+    }
+    m_perfect_hash.reset();
+    if(other.m_perfect_hash) {
+        freeze();
+    }
+
+    std::lock_guard<std::mutex> lock(m_layout_mutex);
+    bool relaid_out;
+    {
+        std::lock_guard<std::mutex> other_lock(other.m_layout_mutex);
+        m_word_weights = other.m_word_weights;
+        m_word_weight_key_bytes = other.m_word_weight_key_bytes;
+        m_hit_counts = other.m_hit_counts;
+        m_child_order = std::make_shared<string_dict_child_order>(other.m_child_order->expected_char_first());
+        relaid_out = other.m_child_order->is_relaid_out();
+    }
+    m_records_hits = other.m_records_hits.load();
+    if(m_perfect_hash) {
+        // Hits recorded by other since its last relayout() are given to the
+        // counters of this thread.
+        std::vector<double> hit_counts(m_perfect_hash->size(), 0);
+        other.merge_hit_counts(hit_counts, false);
+        if(std::any_of(hit_counts.begin(), hit_counts.end(), [](double hit_count) { return hit_count > 0; })) {
+            std::vector<std::atomic<std::uint32_t>> &counts = thread_hit_counts();
+            for(size_t id = 0; id < hit_counts.size(); id++) {
+                counts[id].store(static_cast<std::uint32_t>(hit_counts[id]), std::memory_order_relaxed);
+            }
+        }
+    }
+    if(relaid_out) {
+        publish_layout(true);
+    }
+}
+
 bool word_dict::add_word(const std::string &word)
 {
-    return string_dict_utils::add_string(m_words, word);
+    m_qgram_index.reset();
+    m_perfect_hash.reset();
+    m_records_hits = false;
+    reset_layout();
+    size_t nb_nodes_added;
+    const bool added = string_dict_utils::add_string(m_words, word, &nb_nodes_added);
+    m_node_count += nb_nodes_added;
+    m_word_count += nb_nodes_added > 0 ? 1 : 0; // the end-of-word marker node is added last
+    return added;
+}
+
+size_t word_dict::add_words(const std::vector<std::string> &words,
+                            unsigned int nb_threads,
+                            unsigned int prefix_length)
+{
+    m_qgram_index.reset();
+    m_perfect_hash.reset();
+    m_records_hits = false;
+    reset_layout();
+    const size_t nb_words_added = string_dict_utils::add_strings(m_words, words, nb_threads, prefix_length);
+    recount();
+    return nb_words_added;
+}
+
+void word_dict::freeze()
+{
+    m_perfect_hash.reset(new string_dict_perfect_hash(m_words));
+}
+
+bool word_dict::contains(const std::string &word) const
+{
+    if(m_perfect_hash) {
+        return m_perfect_hash->contains(word);
+    }
+    return string_dict_utils::match_string_exactly(m_words, word).success;
+}
+
+size_t word_dict::word_id(const std::string &word) const
+{
+    return m_perfect_hash ? m_perfect_hash->id(word) : npos;
 }
 
 string_dict_utils::match_data word_dict::match_word_exactly(const std::string &word) const
 {
-    return string_dict_utils::match_string_exactly(m_words, word);
+    // Words which are not found by the perfect hash are looked up in the
+    // tree anyway, to tell where they failed to match.
+    string_dict_utils::match_data match;
+    if(m_perfect_hash && m_perfect_hash->contains(word)) {
+        match.set(
+            "exact-match",
+            word,
+            true,
+            [&]() { return "\"" + word + end_of_word_marker() + "\" matched successfully"; },
+            []() { return std::string(); }
+        );
+        match.matched = word + end_of_word_marker();
+    }
+    else {
+        match = string_dict_utils::match_string_exactly(m_words, word);
+    }
+    record_hit(match);
+    return match;
 }
 
 string_dict_utils::match_data word_dict::match_word_allow_substitution(const std::string &word,
-                                                                       unsigned int subst_max) const
+                                                                       unsigned int subst_max,
+                                                                       string_dict_utils::traversal strategy) const
 {
-    return string_dict_utils::match_string_allow_substitution(
+    const string_dict_utils::match_data &match = string_dict_utils::match_string_allow_substitution(
         m_words,
         word,
-        subst_max
+        subst_max,
+        strategy,
+        child_order().get()
     );
+    record_hit(match);
+    return match;
 }
 
 string_dict_utils::match_data word_dict::match_word_levenshtein_distance(const std::string &word,
-                                                                         unsigned int edit_max) const
+                                                                         unsigned int edit_max,
+                                                                         string_dict_utils::traversal strategy) const
 {
-    return string_dict_utils::match_string_levenshtein_distance(
+    const string_dict_utils::match_data &match = string_dict_utils::match_string_levenshtein_distance(
         m_words,
         word,
-        edit_max
+        edit_max,
+        strategy,
+        child_order().get()
     );
+    record_hit(match);
+    return match;
+}
+
+string_dict_utils::match_data word_dict::match_closest_word_levenshtein_distance(const std::string &word,
+                                                                                 unsigned int edit_max) const
+{
+    // The tree is traversed almost entirely for large edit budgets (the costs
+    // of the first levels never exceed the budget), so the q-gram index is
+    // preferred when it prunes candidates for words of that length. Both ways
+    // give the same result.
+    if(m_qgram_index && edit_max >= qgram_index_edit_min && m_qgram_index->prunes(word.length(), edit_max)) {
+        const string_dict_utils::match_data &match = m_qgram_index->match_string_levenshtein_distance(word, edit_max);
+        record_hit(match);
+        return match;
+    }
+
+    const string_dict_utils::match_data &match = string_dict_utils::match_closest_string_levenshtein_distance(m_words, word, edit_max);
+    record_hit(match);
+    return match;
+}
+
+void word_dict::build_qgram_index(unsigned int q)
+{
+    m_qgram_index.reset(new string_dict_qgram_index(m_words, q));
+}
+
+std::vector<string_dict_utils::match_data> word_dict::match_words_levenshtein_distance(const std::vector<std::string> &words,
+                                                                                      unsigned int edit_max) const
+{
+    const std::vector<string_dict_utils::match_data> &matches = string_dict_utils::match_strings_levenshtein_distance(m_words, words, edit_max);
+    for(const string_dict_utils::match_data &match : matches) {
+        record_hit(match);
+    }
+    return matches;
+}
+
+void word_dict::set_word_weight(const std::string &word, double weight)
+{
+    std::lock_guard<std::mutex> lock(m_layout_mutex);
+    const auto inserted = m_word_weights.emplace(word, weight);
+    if(inserted.second) {
+        m_word_weight_key_bytes += string_dict_utils::allocated_bytes(inserted.first->first);
+    }
+    else {
+        inserted.first->second = weight;
+    }
+}
+
+bool word_dict::record_hits(bool enabled)
+{
+    if(enabled && !is_frozen()) {
+        return false; // hits are counted by word identifier
+    }
+    m_records_hits = enabled;
+    return true;
+}
+
+void word_dict::relayout()
+{
+    std::lock_guard<std::mutex> lock(m_layout_mutex);
+    if(m_perfect_hash) {
+        m_hit_counts.resize(m_perfect_hash->size(), 0);
+        for(double &hit_count : m_hit_counts) {
+            hit_count *= hit_count_decay;
+        }
+        merge_hit_counts(m_hit_counts, true);
+    }
+    publish_layout(true);
+}
+
+void word_dict::set_expected_char_first(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_layout_mutex);
+    const std::shared_ptr<string_dict_child_order> &order = std::make_shared<string_dict_child_order>(*m_child_order);
+    order->set_expected_char_first(enabled);
+    std::atomic_store(&m_child_order, std::shared_ptr<const string_dict_child_order>(order));
 }
 
 void word_dict::fetch_words(std::vector<std::string> &words) const
@@ -59,6 +324,195 @@ void word_dict::fetch_words(std::vector<std::string> &words) const
     string_dict_utils::fetch_tree_strings(m_words, words);
 }
 
+void word_dict::fetch_words(std::vector<std::string> &words,
+                            const std::string &after,
+                            size_t max_count) const
+{
+    string_dict_utils::fetch_tree_strings(m_words, words, after, max_count);
+}
+
+void word_dict::fetch_words_parallel(std::vector<std::string> &words,
+                                     unsigned int nb_threads) const
+{
+    string_dict_utils::fetch_tree_strings_parallel(m_words, nb_threads, words);
+}
+
+word_dict::const_iterator word_dict::begin() const
+{
+    return const_iterator(m_words.root());
+}
+
+word_dict::const_iterator word_dict::end() const
+{
+    return const_iterator();
+}
+
+word_dict::const_iterator word_dict::words_after(const std::string &word) const
+{
+    return const_iterator(m_words.root(), "", word);
+}
+
+string_dict_scanner word_dict::scanner() const
+{
+    return string_dict_scanner(m_words);
+}
+
+fuzzy_session word_dict::start_fuzzy_session(unsigned int edit_max) const
+{
+    return fuzzy_session(*this, edit_max);
+}
+
+word_dict::memory_footprint word_dict::memory_stats() const
+{
+    memory_footprint footprint;
+    footprint.tree = dtree_utils::compute_tree_stats(m_words);
+    footprint.word_count = footprint.tree.node_count > 1 ? footprint.tree.leaf_count : 0; // see recount()
+    count_allocated_bytes(footprint);
+    return footprint;
+}
+
+word_dict::memory_footprint word_dict::memory_counters() const
+{
+    const size_t node_bytes = dtree_utils::node_allocation_bytes<char, dtree<char>::node_t::allocator_type>();
+    memory_footprint footprint;
+    footprint.tree.node_count = m_node_count;
+    footprint.tree.leaf_count = m_node_count > 1 ? m_word_count : 1;
+    footprint.tree.payload_bytes = (m_node_count - 1) * sizeof(char);
+    footprint.tree.container_bytes = sizeof(m_words.root()) + (m_node_count - 1) * (node_bytes - sizeof(char));
+    footprint.word_count = m_word_count;
+    count_allocated_bytes(footprint);
+    return footprint;
+}
+
+void word_dict::recount()
+{
+    // Leaves are exactly the end-of-word marker nodes, except for the root of
+    // an empty tree.
+    const dtree_utils::tree_stats &stats = dtree_utils::compute_tree_stats(m_words);
+    m_node_count = stats.node_count;
+    m_word_count = stats.node_count > 1 ? stats.leaf_count : 0;
+}
+
+void word_dict::reset_layout()
+{
+    // Words are never added while matched, so no lock is needed. Identifiers
+    // of words change as words are added, so hits are dropped along with the
+    // layout.
+    if(m_child_order->is_relaid_out()) {
+        publish_layout(false);
+    }
+    m_hit_counts.clear();
+    if(!m_hit_counters.empty()) {
+        m_hit_counters.clear();
+        m_hit_counters_serial = new_hit_counters_serial();
+    }
+}
+
+void word_dict::publish_layout(bool relaid_out)
+{
+    // The layout is built aside while words are matched with the previous
+    // one, then replaces it atomically (see child_order()). m_layout_mutex
+    // must be held unless words are being added.
+    const std::shared_ptr<string_dict_child_order> &order = std::make_shared<string_dict_child_order>(m_child_order->expected_char_first());
+    if(relaid_out) {
+        order->relayout(m_words, [this](const std::string &word) {
+            const auto weight_it = m_word_weights.find(word);
+            const size_t id = m_perfect_hash ? m_perfect_hash->id(word) : npos;
+            return (weight_it != m_word_weights.end() ? weight_it->second : 0)
+                 + (id < m_hit_counts.size() ? m_hit_counts[id] : 0);
+        });
+    }
+    std::atomic_store(&m_child_order, std::shared_ptr<const string_dict_child_order>(order));
+}
+
+std::shared_ptr<const string_dict_child_order> word_dict::child_order() const
+{
+    // The order is held until words are matched, even if replaced meanwhile.
+    const std::shared_ptr<const string_dict_child_order> &order = std::atomic_load(&m_child_order);
+    return order->is_default() ? nullptr : order;
+}
+
+void word_dict::record_hit(const string_dict_utils::match_data &match) const
+{
+    // Logic: each thread caches the counters it was given by the dictionary
+    //        for which it last recorded hits, along with their serial number,
+    //        so hits are recorded without lock nor allocation as long as a
+    //        thread records hits for the same dictionary.
+    if(!m_records_hits.load(std::memory_order_relaxed) || !match.success || !m_perfect_hash) {
+        return;
+    }
+    const size_t id = m_perfect_hash->id(match.matched.data(), match.matched.length() - 1); // without end-of-word marker
+    if(id == npos) {
+        return;
+    }
+    thread_local cached_hit_counters cached_counters {0, nullptr};
+    if(cached_counters.serial != m_hit_counters_serial) {
+        cached_counters.counts = &thread_hit_counts();
+        cached_counters.serial = m_hit_counters_serial;
+    }
+    (*cached_counters.counts)[id].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<std::atomic<std::uint32_t>>& word_dict::thread_hit_counts() const
+{
+    const std::thread::id thread_id = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(m_hit_counters_mutex);
+    for(hit_counters &counters : m_hit_counters) {
+        if(counters.thread_id == thread_id) {
+            return counters.counts;
+        }
+    }
+    m_hit_counters.emplace_back();
+    m_hit_counters.back().thread_id = thread_id;
+    m_hit_counters.back().counts = std::vector<std::atomic<std::uint32_t>>(m_perfect_hash->size());
+    return m_hit_counters.back().counts;
+}
+
+void word_dict::merge_hit_counts(std::vector<double> &hit_counts, bool reset) const
+{
+    std::lock_guard<std::mutex> lock(m_hit_counters_mutex);
+    for(hit_counters &counters : m_hit_counters) {
+        const size_t nb_counts = std::min(counters.counts.size(), hit_counts.size());
+        for(size_t id = 0; id < nb_counts; id++) {
+            hit_counts[id] += reset ? counters.counts[id].exchange(0, std::memory_order_relaxed)
+                                    : counters.counts[id].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void word_dict::count_allocated_bytes(memory_footprint &footprint) const
+{
+    const size_t node_bytes = dtree_utils::node_allocation_bytes<char, dtree<char>::node_t::allocator_type>();
+    footprint.marker_bytes = footprint.word_count * node_bytes;
+    if(m_resource) {
+        footprint.allocated_bytes = m_resource->bytes_allocated();
+        footprint.reserved_bytes = m_resource->bytes_reserved();
+    }
+    else {
+        footprint.allocated_bytes = (footprint.tree.node_count - 1) * node_bytes; // root is not allocated
+        footprint.reserved_bytes = (footprint.tree.node_count - 1) * heap_allocation_bytes(node_bytes);
+    }
+
+    // Side structures.
+    if(m_qgram_index) {
+        footprint.qgram_index_bytes = m_qgram_index->bytes();
+    }
+    if(m_perfect_hash) {
+        footprint.perfect_hash_bytes = m_perfect_hash->bytes();
+    }
+    footprint.child_order_bytes = std::atomic_load(&m_child_order)->bytes();
+    {
+        std::lock_guard<std::mutex> lock(m_layout_mutex);
+        footprint.hit_count_bytes = string_dict_utils::allocated_bytes(m_hit_counts);
+        footprint.word_weight_bytes = string_dict_utils::allocated_bytes(m_word_weights) + m_word_weight_key_bytes;
+    }
+    std::lock_guard<std::mutex> lock(m_hit_counters_mutex);
+    for(const hit_counters &counters : m_hit_counters) {
+        footprint.hit_count_bytes += sizeof(counters) + 2 * sizeof(void*) // list node
+                                   + string_dict_utils::allocated_bytes(counters.counts);
+    }
+}
+
 void word_dict::print_words_tree(std::ostream &stream) const
 {
     string_dict_utils::print_tree_structure(m_words, stream);
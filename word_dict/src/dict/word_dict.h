@@ -25,30 +25,209 @@
 #ifndef WORD_DICT_H
 #define WORD_DICT_H
 
+#include "fuzzy_session.h"
+#include "string_dict_child_order.h"
+#include "string_dict_perfect_hash.h"
+#include "string_dict_qgram_index.h"
+#include "string_dict_scanner.h"
 #include "string_dict_utils.h"
 
+#include "dtree_utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 /// Dictionary of words (strings).
 class word_dict
 {
 public:
-    explicit word_dict() {}
+    typedef string_dict_utils::string_iterator const_iterator; // iterator over words (see fetch_words())
+
+    /// Where the nodes of the underlying tree are allocated. Dictionaries using
+    /// an arena or a pool are destroyed in O(1) (see dtree_resources.hpp).
+    enum class memory_policy {
+        heap,  // global operator new (one allocation per node)
+        arena, // monotonic arena, best for dictionaries built once
+        pool,  // size-class pool, best for dictionaries modified often
+    };
+
+    /// Memory footprint of the dictionary (see memory_stats()).
+    typedef struct {
+        dtree_utils::tree_stats tree;   // shape and size of the underlying tree
+        size_t word_count {0};          // number of words, i.e. of end-of-word marker nodes
+        size_t marker_bytes {0};        // bytes allocated for the end-of-word marker nodes
+        size_t allocated_bytes {0};     // bytes allocated for the nodes of tree
+        size_t reserved_bytes {0};      // bytes obtained from the system to that end (estimated for the heap memory policy)
+        size_t qgram_index_bytes {0};   // estimated bytes allocated for the q-gram index (see build_qgram_index())
+        size_t perfect_hash_bytes {0};  // estimated bytes allocated for the perfect hash (see freeze())
+        size_t child_order_bytes {0};   // estimated bytes allocated for the layout (see relayout())
+        size_t hit_count_bytes {0};     // estimated bytes allocated for the hits recorded (see record_hits())
+        size_t word_weight_bytes {0};   // estimated bytes allocated for the weights of words (see set_word_weight())
+
+        size_t allocator_overhead_bytes() const { return reserved_bytes - allocated_bytes; }
+        size_t side_structure_bytes() const
+        {
+            return qgram_index_bytes + perfect_hash_bytes + child_order_bytes + hit_count_bytes + word_weight_bytes;
+        }
+        size_t total_bytes() const { return reserved_bytes + side_structure_bytes(); }
+    } memory_footprint;
+
+    static const size_t npos; // identifier of words not in the dictionary (see word_id())
+
+public:
+    explicit word_dict(memory_policy policy = memory_policy::heap);
+    /// Copies are deep: the words of other are copied into a tree allocated
+    /// with a memory resource of the same policy, and the q-gram index,
+    /// perfect hash and layout of other (if any) are rebuilt for the copy.
+    word_dict(const word_dict &other);
+    word_dict& operator=(const word_dict &other);
 
     bool add_word(const std::string &word);
+    size_t add_words(const std::vector<std::string> &words,
+                     unsigned int nb_threads = 0,
+                     unsigned int prefix_length = 1);
+
+    /// Builds the minimal perfect hash of the words used by contains(),
+    /// word_id() and match_word_exactly() (see string_dict_perfect_hash), for
+    /// dictionaries which don't change once loaded. The hash doesn't store
+    /// the words, so a frozen dictionary may accept a word it doesn't have
+    /// with a probability of about number_of_words / 2^64. Adding words
+    /// unfreezes the dictionary (the hash is dropped).
+    void freeze();
+    bool is_frozen() const { return m_perfect_hash != nullptr; }
+    bool contains(const std::string &word) const;
+    /// Returns the identifier of word (its index in the order of begin() to
+    /// end()), or npos if word is not in the dictionary or the dictionary is
+    /// not frozen.
+    size_t word_id(const std::string &word) const;
 
     string_dict_utils::match_data match_word_exactly(const std::string &word) const;
     string_dict_utils::match_data match_word_allow_substitution(const std::string &word,
-                                                                unsigned int subst_max = 0) const;
+                                                                unsigned int subst_max = 0,
+                                                                string_dict_utils::traversal strategy = string_dict_utils::traversal::depth_first) const;
+    /// Returns the first word found within edit_max by the given traversal
+    /// (see set_expected_char_first() and relayout() for the depth-first
+    /// traversal), which need not be the closest one.
     string_dict_utils::match_data match_word_levenshtein_distance(const std::string &word,
-                                                                  unsigned int edit_max = 0) const;
+                                                                  unsigned int edit_max = 0,
+                                                                  string_dict_utils::traversal strategy = string_dict_utils::traversal::depth_first) const;
+    /// Same as above except that the word matched (if any) is the one with the
+    /// lowest distance, the first one in the order of the dictionary (see
+    /// begin()) in case of tie. The result doesn't depend on how it is
+    /// computed: through the q-gram index when it is built and pays off for
+    /// large edit budgets, through a depth-first traversal of the dictionary
+    /// otherwise (see string_dict_utils::match_closest_string_levenshtein_distance()).
+    string_dict_utils::match_data match_closest_word_levenshtein_distance(const std::string &word,
+                                                                          unsigned int edit_max = 0) const;
+    /// Builds the q-gram index used by match_closest_word_levenshtein_distance()
+    /// (see string_dict_qgram_index). The index is dropped whenever words are
+    /// added, so it should be built once all words are.
+    void build_qgram_index(unsigned int q = 2);
+    bool has_qgram_index() const { return m_qgram_index != nullptr; }
+    /// Returns the closest word within edit_max for each given word, as
+    /// match_closest_word_levenshtein_distance() does (results are returned in
+    /// the same order as words). The work done for the prefixes shared by
+    /// words is shared too, which pays off for small edit budgets only (see
+    /// string_dict_utils::match_strings_levenshtein_distance()).
+    std::vector<string_dict_utils::match_data> match_words_levenshtein_distance(const std::vector<std::string> &words,
+                                                                                unsigned int edit_max = 0) const;
+
+    /// The depth-first fuzzy string-matching-algorithms stop at the first word
+    /// matched, which depends on the order in which they visit the children of
+    /// nodes (see string_dict_child_order). relayout() orders children by
+    /// decreasing weight of the words in their subtree, the weight of a word
+    /// being the one set by set_word_weight() plus the number of times it was
+    /// matched while hits were recorded, hits recorded before the previous
+    /// relayout() counting half as much at each relayout(). The new layout is
+    /// built aside and replaces the previous one atomically, so relayout(),
+    /// set_word_weight() and set_expected_char_first() may be called while
+    /// words are matched (but not while words are added). Hits are counted by
+    /// word identifier in counters of the thread matching words, so the
+    /// dictionary must be frozen (see freeze()) for record_hits() to enable
+    /// the recording, which it refuses otherwise (returning false). The
+    /// layout and hits are dropped whenever words are added, and the
+    /// recording is disabled since the dictionary is no longer frozen.
+    void set_word_weight(const std::string &word, double weight);
+    bool record_hits(bool enabled);
+    void relayout();
+    /// Makes the depth-first fuzzy string-matching-algorithms try the child
+    /// read from the character expected in the matched word first.
+    void set_expected_char_first(bool enabled);
 
     void fetch_words(std::vector<std::string> &words) const;
+    void fetch_words(std::vector<std::string> &words,
+                     const std::string &after,
+                     size_t max_count) const;
+    void fetch_words_parallel(std::vector<std::string> &words,
+                              unsigned int nb_threads = 0) const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator words_after(const std::string &word) const;
+    string_dict_scanner scanner() const;
+    fuzzy_session start_fuzzy_session(unsigned int edit_max = 0) const;
+
+    /// Computes the memory footprint of the dictionary by traversing the
+    /// underlying tree (without recursion). The side structures (q-gram index,
+    /// perfect hash, layout, hits and weights of words) are reported apart
+    /// from the tree, from sizes recorded when they are built.
+    memory_footprint memory_stats() const;
+    /// Same as above from counters maintained as words are added, for live
+    /// monitoring (in O(1) but for the hit counters of each thread). The
+    /// height and histograms of the tree are left empty. Like the other const
+    /// functions, it may be called while words are matched but not while
+    /// words are added: the counters, the memory resource and the side
+    /// structures are updated then without synchronization.
+    memory_footprint memory_counters() const;
+
     void print_words_tree(std::ostream &stream) const;
     void print_words_values(std::ostream &stream) const;
 
     static char end_of_word_marker();
 
 private:
+    friend class fuzzy_session;
+
+    // Hits recorded by one thread, by word identifier (see record_hits()).
+    typedef struct {
+        std::thread::id thread_id;
+        std::vector<std::atomic<std::uint32_t>> counts;
+    } hit_counters;
+
+    void copy_from(const word_dict &other);
+    void recount();
+    void count_allocated_bytes(memory_footprint &footprint) const;
+    void reset_layout();
+    void publish_layout(bool relaid_out);
+    std::shared_ptr<const string_dict_child_order> child_order() const;
+    void record_hit(const string_dict_utils::match_data &match) const;
+    std::vector<std::atomic<std::uint32_t>>& thread_hit_counts() const;
+    void merge_hit_counts(std::vector<double> &hit_counts, bool reset) const;
+
+    const memory_policy m_policy;
+    std::unique_ptr<dtree_memory_resource> m_resource; // must outlive m_words
     dtree<char> m_words;
+    std::unique_ptr<string_dict_qgram_index> m_qgram_index; // see build_qgram_index()
+    std::unique_ptr<string_dict_perfect_hash> m_perfect_hash; // see freeze()
+
+    // See memory_counters() (updated along with the tree, so not atomic).
+    size_t m_node_count {1};
+    size_t m_word_count {0};
+
+    // See relayout().
+    mutable std::mutex m_layout_mutex; // held while the layout or the weights of words change
+    std::shared_ptr<const string_dict_child_order> m_child_order; // never null, read and replaced atomically
+    std::unordered_map<std::string, double> m_word_weights;
+    size_t m_word_weight_key_bytes {0}; // bytes allocated by the words of m_word_weights
+    std::vector<double> m_hit_counts; // hits merged by relayout() (with decay), by word identifier
+    std::atomic<bool> m_records_hits {false};
+    mutable std::mutex m_hit_counters_mutex; // held while hit counters are added or merged
+    mutable std::list<hit_counters> m_hit_counters; // hits recorded since the last relayout(), per thread
+    std::uint64_t m_hit_counters_serial; // changes whenever hit counters are dropped (see record_hit())
 };
 
 #endif // WORD_DICT_H
@@ -40,9 +40,36 @@ int main()
     dict.print_words_values(std::cout);
     std::cout << std::endl;
 
+    std::cout << "--- Print words by page ---" << std::endl;
+    print_words_by_page(dict, 4);
+    std::cout << std::endl;
+
+    std::cout << "--- Print memory stats ---" << std::endl;
+    print_memory_stats(dict);
+    std::cout << std::endl;
+
+    std::cout << "--- Print memory stats of frozen and indexed copy ---" << std::endl;
+    word_dict frozen_dict(dict);
+    frozen_dict.freeze();
+    frozen_dict.build_qgram_index();
+    frozen_dict.set_word_weight("b", 2);
+    frozen_dict.record_hits(true);
+    frozen_dict.match_word_exactly("abb");
+    frozen_dict.relayout();
+    print_memory_stats(frozen_dict);
+    std::cout << std::endl;
+
     std::cout << "--- Match sample words ---" << std::endl;
     match_sample_words(dict);
     std::cout << std::endl;
 
+    std::cout << "--- Type sample word ---" << std::endl;
+    type_sample_word(dict);
+    std::cout << std::endl;
+
+    std::cout << "--- Scan sample text ---" << std::endl;
+    scan_sample_text(dict);
+    std::cout << std::endl;
+
     return 0;
 }
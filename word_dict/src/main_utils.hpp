@@ -58,6 +58,87 @@ void match_words(const word_dict &dict, const std::vector<std::string> &words)
     }
 }
 
+void print_words_by_page(const word_dict &dict, size_t page_size)
+{
+    std::vector<std::string> page;
+    for(auto it = dict.begin(); it != dict.end() && page.size() < page_size; ++it) {
+        page.push_back(*it);
+    }
+
+    for(size_t page_index = 1; !page.empty(); page_index++) {
+        std::cout << "page " << page_index << ":";
+        for(const std::string &word : page) {
+            std::cout << " " << word;
+        }
+        std::cout << std::endl;
+
+        const std::string cursor = page.back(); // last word read so far
+        dict.fetch_words(page, cursor, page_size);
+    }
+}
+
+void print_memory_stats(const word_dict &dict)
+{
+    const auto &histogram_str = [](const std::vector<size_t> &histogram) {
+        std::string str;
+        for(size_t i = 0; i < histogram.size(); i++) {
+            str += (i == 0 ? "" : " ") + std::to_string(histogram[i]);
+        }
+        return str;
+    };
+
+    const word_dict::memory_footprint &footprint = dict.memory_stats();
+    std::cout << "nodes: " << footprint.tree.node_count
+              << " (leaves: " << footprint.tree.leaf_count << ", height: " << footprint.tree.height << ")" << std::endl
+              << "words: " << footprint.word_count << " (marker nodes: " << footprint.marker_bytes << " bytes)" << std::endl
+              << "nodes per number of children: " << histogram_str(footprint.tree.fanout_histogram) << std::endl
+              << "nodes per depth: " << histogram_str(footprint.tree.depth_histogram) << std::endl
+              << "payload: " << footprint.tree.payload_bytes << " bytes, containers: "
+              << footprint.tree.container_bytes << " bytes" << std::endl
+              << "allocated: " << footprint.allocated_bytes << " bytes, reserved: " << footprint.reserved_bytes
+              << " bytes (allocator overhead: " << footprint.allocator_overhead_bytes() << " bytes)" << std::endl
+              << "q-gram index: " << footprint.qgram_index_bytes << " bytes, perfect hash: " << footprint.perfect_hash_bytes
+              << " bytes, child order: " << footprint.child_order_bytes << " bytes, hit counts: " << footprint.hit_count_bytes
+              << " bytes, word weights: " << footprint.word_weight_bytes << " bytes" << std::endl
+              << "total: " << footprint.total_bytes() << " bytes" << std::endl;
+}
+
+void scan_text(const word_dict &dict, const std::string &text)
+{
+    const unsigned int min = 0;
+    const unsigned int max = 1;
+
+    string_dict_scanner scanner = dict.scanner();
+    for(unsigned int i = min; i <= max; i++) {
+        std::cout << "scanning \"" << text << "\" with at most " << i << " edits:";
+        scanner.reset(i);
+        scanner.feed(text, [&scanner](const string_dict_scanner::occurrence &occurrence) {
+            std::cout << " (" << occurrence.offset << ", \"" << scanner.word(occurrence.word_id)
+                      << "\", " << occurrence.cost << ")";
+        });
+        std::cout << std::endl;
+    }
+}
+
+void type_word(const word_dict &dict, const std::string &word, unsigned int edit_max)
+{
+    const auto &candidates_str = [](const std::vector<fuzzy_session::candidate> &candidates) {
+        std::string str;
+        for(const fuzzy_session::candidate &candidate : candidates) {
+            str += " \"" + candidate.word + "\"(" + std::to_string(candidate.cost) + ")";
+        }
+        return str;
+    };
+
+    fuzzy_session session = dict.start_fuzzy_session(edit_max);
+    for(const char c : word) {
+        session.push_char(c);
+        std::cout << "typing \"" << session.word() << "\" with at most " << edit_max << " edits:" << std::endl
+                  << "    matches:" << candidates_str(session.matches()) << std::endl
+                  << "    prefix matches:" << candidates_str(session.prefix_matches()) << std::endl;
+    }
+}
+
 void add_sample_words(word_dict &dict)
 {
     add_words(dict, {
@@ -83,4 +164,14 @@ void match_sample_words(const word_dict &dict)
     });
 }
 
+void type_sample_word(const word_dict &dict)
+{
+    type_word(dict, "abx", 1);
+}
+
+void scan_sample_text(const word_dict &dict)
+{
+    scan_text(dict, "xabaabbz");
+}
+
 #endif // MAIN_UTILS_H
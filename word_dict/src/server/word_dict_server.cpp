@@ -0,0 +1,422 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "word_dict_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Protocol: each request is one line and gets one response line. Requests are
+// (the word is the rest of the line so it may contain spaces):
+//     E <word>          exact match
+//     S <max> <word>    match allowing at most <max> substitutions
+//     L <max> <word>    match within a Levenshtein distance of at most <max>
+//                       (the first word found by the traversal strategy)
+//     C <max> <word>    same as L but the closest word is matched (the first
+//                       one in the order of the dictionary in case of tie)
+//     STATS             server statistics
+// Responses are:
+//     + <cost> <word>   word matched (<cost> is the number of operations)
+//     -                 no word matched
+//     + <key>=<value>... statistics (space-separated)
+//     ! <message>       invalid request
+// Budgets larger than limits::budget_max are rejected, and a request longer
+// than limits::line_length_max is answered with an error before the
+// connection is closed (so a client cannot make the server buffer an endless
+// line).
+// Many requests can be sent without waiting for responses (pipelining): all
+// the complete lines read at once form a batch answered by several threads.
+
+namespace {
+
+const size_t read_buffer_size {1 << 16};
+
+// Minimal number of requests in a batch for the batch to be shared between
+// worker threads (smaller batches are answered by the reading thread).
+const size_t parallel_batch_size_min {8};
+
+// Parses a budget followed by a space and returns the position of the word
+// after it, or std::string::npos on error.
+size_t parse_budget(const std::string &request, size_t pos, unsigned int &budget)
+{
+    const size_t digits_end = request.find(' ', pos);
+    if(digits_end == std::string::npos || digits_end == pos || digits_end - pos > 9) {
+        return std::string::npos;
+    }
+    budget = 0;
+    for(size_t i = pos; i < digits_end; i++) {
+        if(request[i] < '0' || request[i] > '9') {
+            return std::string::npos;
+        }
+        budget = budget * 10 + (request[i] - '0');
+    }
+    return digits_end + 1;
+}
+
+bool write_all(int fd, const std::string &data)
+{
+    size_t written = 0;
+    while(written < data.length()) {
+        const ssize_t n = ::write(fd, data.data() + written, data.length() - written);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+} // namespace
+
+word_dict_server::word_dict_server(const word_dict &dict,
+                                   unsigned int nb_threads,
+                                   string_dict_utils::traversal strategy,
+                                   const limits &server_limits)
+    : m_dict(dict)
+    , m_strategy(strategy)
+    , m_limits(server_limits)
+{
+    if(nb_threads == 0) {
+        nb_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for(unsigned int i = 1; i < nb_threads; i++) { // the thread running a batch takes part as well
+        m_workers.emplace_back(&word_dict_server::run_worker, this);
+    }
+}
+
+word_dict_server::~word_dict_server()
+{
+    join_clients(false);
+    {
+        std::lock_guard<std::mutex> lock(m_job_mutex);
+        m_stopping = true;
+    }
+    m_job_started.notify_all();
+    for(std::thread &worker : m_workers) {
+        worker.join();
+    }
+}
+
+bool word_dict_server::serve(int in_fd, int out_fd)
+{
+    m_nb_clients++;
+
+    std::vector<char> buffer(read_buffer_size);
+    std::string pending; // read characters not forming a complete line yet
+    std::vector<std::string> requests;
+    std::vector<std::string> responses;
+    std::string output;
+
+    bool end_of_input {false};
+    while(!end_of_input) {
+        const ssize_t n = ::read(in_fd, buffer.data(), buffer.size());
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if(n == 0) {
+            end_of_input = true;
+            if(pending.empty()) {
+                break;
+            }
+            pending += '\n'; // answer last request even if not terminated
+        }
+        else {
+            pending.append(buffer.data(), n);
+        }
+
+        // Gather complete lines into a batch.
+        requests.clear();
+        size_t line_start = 0;
+        bool line_too_long {false};
+        for(size_t line_end; (line_end = pending.find('\n', line_start)) != std::string::npos; line_start = line_end + 1) {
+            size_t line_length = line_end - line_start;
+            if(line_length > 0 && pending[line_end-1] == '\r') {
+                line_length--;
+            }
+            if(line_length > m_limits.line_length_max) {
+                line_too_long = true;
+                break;
+            }
+            requests.push_back(pending.substr(line_start, line_length));
+        }
+        pending.erase(0, line_start);
+        if(pending.length() > m_limits.line_length_max + 1) { // + 1 for '\r'
+            line_too_long = true;
+        }
+        if(requests.empty() && !line_too_long) {
+            continue;
+        }
+
+        // Answer batch and write all responses at once.
+        output.clear();
+        if(!requests.empty()) {
+            answer_batch(requests, responses);
+            for(const std::string &response : responses) {
+                output += response;
+                output += '\n';
+            }
+        }
+        if(line_too_long) {
+            m_nb_requests++;
+            m_nb_errors++;
+            output += "! request too long\n";
+        }
+        if(!write_all(out_fd, output)) {
+            return false;
+        }
+        if(line_too_long) {
+            break; // the rest of the line cannot be told apart from requests
+        }
+    }
+    return true;
+}
+
+bool word_dict_server::serve_unix_socket(const std::string &path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(path.length() >= sizeof(address.sun_path)) {
+        std::cerr << "socket path too long: " << path << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    const int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server_fd < 0) {
+        std::cerr << "socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    ::unlink(path.c_str());
+    if(::bind(server_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+    || ::listen(server_fd, SOMAXCONN) < 0) {
+        std::cerr << "cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(server_fd);
+        return false;
+    }
+
+    for(;;) {
+        const int client_fd = ::accept(server_fd, nullptr, nullptr);
+        if(client_fd < 0) {
+            if(errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::cerr << "accept() failed: " << std::strerror(errno) << std::endl;
+            ::close(server_fd);
+            join_clients(false);
+            return false;
+        }
+
+        join_clients(true);
+        std::lock_guard<std::mutex> lock(m_clients_mutex);
+        if(m_clients.size() >= m_limits.client_count_max) {
+            m_nb_errors++;
+            write_all(client_fd, "! too many clients\n");
+            ::close(client_fd);
+            continue;
+        }
+        m_clients.push_back({std::thread(), client_fd, false});
+        const auto client_it = std::prev(m_clients.end());
+        client_it->thread = std::thread([this, client_it]() {
+            serve(client_it->fd, client_it->fd);
+            std::lock_guard<std::mutex> lock(m_clients_mutex);
+            ::close(client_it->fd);
+            client_it->fd = -1;
+            client_it->finished = true;
+        });
+    }
+}
+
+void word_dict_server::join_clients(bool finished_only)
+{
+    // Threads are joined without holding the mutex since they lock it before
+    // finishing.
+    std::list<client> joinable_clients;
+    {
+        std::lock_guard<std::mutex> lock(m_clients_mutex);
+        for(auto it = m_clients.begin(); it != m_clients.end();) {
+            const auto next = std::next(it);
+            if(it->finished || !finished_only) {
+                if(!it->finished) {
+                    ::shutdown(it->fd, SHUT_RDWR); // unblocks reads and writes
+                }
+                joinable_clients.splice(joinable_clients.end(), m_clients, it);
+            }
+            it = next;
+        }
+    }
+    for(client &joinable_client : joinable_clients) {
+        joinable_client.thread.join();
+    }
+}
+
+std::string word_dict_server::answer(const std::string &request)
+{
+    m_nb_requests++;
+
+    if(request == "STATS") {
+        return stats();
+    }
+
+    const char command = request.empty() ? '\0' : request[0];
+    if(request.length() < 2 || request[1] != ' ' || (command != 'E' && command != 'S' && command != 'L' && command != 'C')) {
+        m_nb_errors++;
+        return "! unknown request";
+    }
+
+    string_dict_utils::match_data match;
+    if(command == 'E') {
+        m_nb_exact_queries++;
+        match = m_dict.match_word_exactly(request.substr(2));
+    }
+    else {
+        unsigned int budget;
+        const size_t word_pos = parse_budget(request, 2, budget);
+        if(word_pos == std::string::npos) {
+            m_nb_errors++;
+            return "! invalid budget";
+        }
+        if(budget > m_limits.budget_max) {
+            m_nb_errors++;
+            return "! budget too large (max " + std::to_string(m_limits.budget_max) + ")";
+        }
+        if(command == 'S') {
+            m_nb_subst_queries++;
+            match = m_dict.match_word_allow_substitution(request.substr(word_pos), budget, m_strategy);
+        }
+        else if(command == 'L') {
+            m_nb_leven_queries++;
+            match = m_dict.match_word_levenshtein_distance(request.substr(word_pos), budget, m_strategy);
+        }
+        else {
+            m_nb_closest_queries++;
+            match = m_dict.match_closest_word_levenshtein_distance(request.substr(word_pos), budget);
+        }
+    }
+
+    if(!match.success) {
+        return "-";
+    }
+    m_nb_matches++;
+    match.matched.pop_back(); // remove end of word marker
+    return "+ " + std::to_string(match.cost) + " " + match.matched;
+}
+
+void word_dict_server::answer_batch(const std::vector<std::string> &requests,
+                                    std::vector<std::string> &responses)
+{
+    m_nb_batches++;
+    responses.resize(requests.size());
+    run_batch_job(requests.size(), [&](size_t i) {
+        responses[i] = answer(requests[i]);
+    });
+}
+
+void word_dict_server::run_batch_job(size_t job_size, const std::function<void (size_t)> &job)
+{
+    if(m_workers.empty() || job_size < parallel_batch_size_min) {
+        for(size_t i = 0; i < job_size; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> batch_lock(m_batch_mutex); // one batch job at a time
+    {
+        std::lock_guard<std::mutex> lock(m_job_mutex);
+        m_job = &job;
+        m_job_size = job_size;
+        m_job_next_index = 0;
+        m_job_generation++;
+    }
+    m_job_started.notify_all();
+
+    for(size_t i = m_job_next_index++; i < job_size; i = m_job_next_index++) {
+        job(i);
+    }
+
+    // Wait for workers still answering requests, then make sure workers
+    // waking up late won't run the job.
+    std::unique_lock<std::mutex> lock(m_job_mutex);
+    m_job_finished.wait(lock, [this]() { return m_job_nb_busy_workers == 0; });
+    m_job = nullptr;
+}
+
+void word_dict_server::run_worker()
+{
+    size_t last_job_generation = 0;
+    std::unique_lock<std::mutex> lock(m_job_mutex);
+    for(;;) {
+        m_job_started.wait(lock, [&]() { return m_stopping || m_job_generation != last_job_generation; });
+        if(m_stopping) {
+            return;
+        }
+        last_job_generation = m_job_generation;
+        if(!m_job) {
+            continue; // job already finished
+        }
+
+        const std::function<void (size_t)> &job = *m_job;
+        const size_t job_size = m_job_size;
+        m_job_nb_busy_workers++;
+        lock.unlock();
+        for(size_t i = m_job_next_index++; i < job_size; i = m_job_next_index++) {
+            job(i);
+        }
+        lock.lock();
+        if(--m_job_nb_busy_workers == 0) {
+            m_job_finished.notify_all();
+        }
+    }
+}
+
+std::string word_dict_server::stats() const
+{
+    const word_dict::memory_footprint &footprint = m_dict.memory_counters();
+    return "+ words=" + std::to_string(footprint.word_count)
+         + " nodes=" + std::to_string(footprint.tree.node_count)
+         + " bytes=" + std::to_string(footprint.total_bytes())
+         + " clients=" + std::to_string(m_nb_clients)
+         + " batches=" + std::to_string(m_nb_batches)
+         + " requests=" + std::to_string(m_nb_requests)
+         + " exact=" + std::to_string(m_nb_exact_queries)
+         + " subst=" + std::to_string(m_nb_subst_queries)
+         + " leven=" + std::to_string(m_nb_leven_queries)
+         + " closest=" + std::to_string(m_nb_closest_queries)
+         + " matches=" + std::to_string(m_nb_matches)
+         + " errors=" + std::to_string(m_nb_errors)
+         + " threads=" + std::to_string(m_workers.size() + 1)
+    ;
+}
@@ -0,0 +1,128 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef WORD_DICT_SERVER_H
+#define WORD_DICT_SERVER_H
+
+#include "word_dict.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+/// Serves queries on a dictionary of words using a line-based protocol over
+/// file descriptors (standard streams or Unix domain socket connections). All
+/// complete requests read at once are answered as one batch, in parallel, and
+/// responses are written in the order of requests. See protocol in *.cpp file.
+class word_dict_server
+{
+public:
+    /// Bounds on the resources a client can make the server use.
+    typedef struct {
+        size_t line_length_max;       // longer requests close the connection
+        unsigned int budget_max;      // larger S, L and C budgets are rejected
+        size_t client_count_max;      // clients served at once over the socket
+    } limits;
+
+    /// Returns the limits used by default.
+    static limits default_limits() { return {4096, 8, 64}; }
+
+public:
+    /// The dictionary must outlive the server and must not be modified while
+    /// being served. nb_threads is the number of threads answering a batch (0
+    /// stands for the number of hardware threads).
+    explicit word_dict_server(const word_dict &dict,
+                              unsigned int nb_threads = 0,
+                              string_dict_utils::traversal strategy = string_dict_utils::traversal::depth_first,
+                              const limits &server_limits = default_limits());
+    ~word_dict_server();
+
+    word_dict_server(const word_dict_server &) = delete;
+    word_dict_server& operator=(const word_dict_server &) = delete;
+
+    /// Answers requests read from in_fd on out_fd until end of input, or
+    /// until a request longer than limits::line_length_max is read (it is
+    /// answered with an error). Returns false on I/O error.
+    bool serve(int in_fd, int out_fd);
+    /// Listens on the Unix domain socket at the given path and serves each
+    /// client from its own thread. Clients connecting while
+    /// limits::client_count_max clients are being served get an error and
+    /// are disconnected. Only returns (false) on error, once the connections
+    /// of the clients being served are shut down and their threads joined.
+    bool serve_unix_socket(const std::string &path);
+
+    /// Returns the response to one request (without end of line).
+    std::string answer(const std::string &request);
+
+private:
+    void answer_batch(const std::vector<std::string> &requests,
+                      std::vector<std::string> &responses);
+    void run_batch_job(size_t job_size, const std::function<void (size_t)> &job);
+    void run_worker();
+    void join_clients(bool finished_only);
+    std::string stats() const;
+
+private:
+    typedef struct {
+        std::thread thread;
+        int fd;
+        bool finished;
+    } client;
+
+    const word_dict &m_dict;
+    const string_dict_utils::traversal m_strategy;
+    const limits m_limits;
+
+    // threads serving socket clients
+    std::list<client> m_clients;
+    std::mutex m_clients_mutex;
+
+    // statistics
+    std::atomic<size_t> m_nb_clients {0};
+    std::atomic<size_t> m_nb_batches {0};
+    std::atomic<size_t> m_nb_requests {0};
+    std::atomic<size_t> m_nb_exact_queries {0};
+    std::atomic<size_t> m_nb_subst_queries {0};
+    std::atomic<size_t> m_nb_leven_queries {0};
+    std::atomic<size_t> m_nb_closest_queries {0};
+    std::atomic<size_t> m_nb_matches {0};
+    std::atomic<size_t> m_nb_errors {0};
+
+    // workers answering batches (one batch job at a time)
+    std::vector<std::thread> m_workers;
+    std::mutex m_batch_mutex;
+    std::mutex m_job_mutex;
+    std::condition_variable m_job_started;
+    std::condition_variable m_job_finished;
+    const std::function<void (size_t)> *m_job {nullptr};
+    size_t m_job_size {0};
+    std::atomic<size_t> m_job_next_index {0};
+    size_t m_job_generation {0};
+    unsigned int m_job_nb_busy_workers {0};
+    bool m_stopping {false};
+};
+
+#endif // WORD_DICT_SERVER_H
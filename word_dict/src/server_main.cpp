@@ -0,0 +1,137 @@
+/*
+ MIT License
+
+ Copyright (c) 2020 Fadyl Sokenou https://github.com/arlogy
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "word_dict_server.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <unistd.h>
+
+namespace {
+
+void print_usage(std::ostream &stream)
+{
+    const word_dict_server::limits &limits = word_dict_server::default_limits();
+    stream << "usage: word_dict_server [--socket <path>] [--threads <n>]"
+              " [--traversal depth_first|level_synchronous] [--max-line <n>]"
+              " [--max-budget <n>] [--max-clients <n>] <dictionary_file>" << std::endl
+           << "Loads one word per line from <dictionary_file> then answers queries"
+              " from standard input (or from clients of the Unix domain socket"
+              " at <path>). See protocol in word_dict_server.cpp." << std::endl
+           << "Requests are at most " << limits.line_length_max << " characters long,"
+              " budgets at most " << limits.budget_max << " and at most "
+           << limits.client_count_max << " clients are served at once by default." << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string socket_path;
+    std::string dictionary_path;
+    unsigned int nb_threads = 0;
+    string_dict_utils::traversal strategy = string_dict_utils::traversal::depth_first;
+    word_dict_server::limits limits = word_dict_server::default_limits();
+
+    for(int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if(arg == "--socket" && has_value) {
+            socket_path = argv[++i];
+        }
+        else if(arg == "--threads" && has_value) {
+            nb_threads = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--traversal" && has_value) {
+            const std::string value = argv[++i];
+            if(value == "depth_first") {
+                strategy = string_dict_utils::traversal::depth_first;
+            }
+            else if(value == "level_synchronous") {
+                strategy = string_dict_utils::traversal::level_synchronous;
+            }
+            else {
+                print_usage(std::cerr);
+                return EXIT_FAILURE;
+            }
+        }
+        else if(arg == "--max-line" && has_value) {
+            limits.line_length_max = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--max-budget" && has_value) {
+            limits.budget_max = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--max-clients" && has_value) {
+            limits.client_count_max = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--help") {
+            print_usage(std::cout);
+            return EXIT_SUCCESS;
+        }
+        else if(dictionary_path.empty() && arg.compare(0, 2, "--") != 0) {
+            dictionary_path = arg;
+        }
+        else {
+            print_usage(std::cerr);
+            return EXIT_FAILURE;
+        }
+    }
+    if(dictionary_path.empty()) {
+        print_usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream dictionary_file(dictionary_path);
+    if(!dictionary_file) {
+        std::cerr << "cannot open " << dictionary_path << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> words;
+    for(std::string word; std::getline(dictionary_file, word);) {
+        if(!word.empty() && word.back() == '\r') {
+            word.pop_back();
+        }
+        words.push_back(word);
+    }
+    word_dict dict(word_dict::memory_policy::arena); // built once
+    const size_t nb_rejected_words = words.size() - dict.add_words(words, nb_threads);
+    words.clear();
+    words.shrink_to_fit();
+    if(nb_rejected_words > 0) {
+        std::cerr << nb_rejected_words << " word(s) containing '"
+                  << word_dict::end_of_word_marker() << "' rejected" << std::endl;
+    }
+    dict.freeze(); // for E requests
+    dict.build_qgram_index(); // for C requests with large budgets
+
+    std::signal(SIGPIPE, SIG_IGN); // write errors are handled per client
+
+    word_dict_server server(dict, nb_threads, strategy, limits);
+    const bool ok = socket_path.empty() ? server.serve(STDIN_FILENO, STDOUT_FILENO)
+                                        : server.serve_unix_socket(socket_path);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}